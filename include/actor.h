@@ -0,0 +1,54 @@
+#ifndef ACTOR_H
+#define ACTOR_H
+
+#include "rtos_config.h"
+
+/* Actor configuration */
+#define ACTOR_MAX_COUNT         8
+#define ACTOR_QUEUE_SIZE        4
+#define ACTOR_STACK_SIZE        DEFAULT_STACK_SIZE
+
+/* Event delivered to an actor */
+typedef struct {
+    uint16_t signal;
+    uint32_t param;
+} actor_event_t;
+
+/* Event handler - runs to completion on the shared dispatcher stack */
+typedef void (*actor_handler_t)(uint8_t actor_id, const actor_event_t* event);
+
+/**
+ * @brief Reset all actors and create the dispatcher task
+ * @return rtos_result_t Success, or RTOS_NO_MEMORY if no task slot is free
+ * @note The dispatcher is an ordinary task in the ready ring: actors share
+ *       its stack and its time slices with the other tasks
+ */
+rtos_result_t actor_init(void);
+
+/**
+ * @brief Create an actor
+ * @param actor_id Actor identifier (0 to ACTOR_MAX_COUNT-1)
+ * @param handler Function called once per event
+ * @param priority 0..MAX_TASK_PRIORITY, higher is dispatched first
+ * @return rtos_result_t Success or error code
+ */
+rtos_result_t actor_create(uint8_t actor_id, actor_handler_t handler, uint8_t priority);
+
+/**
+ * @brief Queue an event for an actor
+ * @param actor_id Actor identifier
+ * @param signal Event type, meaning defined by the actor
+ * @param param Event payload
+ * @return rtos_result_t Success, or RTOS_NO_MEMORY if the actor's queue is full
+ * @note Safe to call from an ISR and from actor handlers
+ */
+rtos_result_t actor_post(uint8_t actor_id, uint16_t signal, uint32_t param);
+
+/**
+ * @brief Number of events waiting for an actor
+ * @param actor_id Actor identifier
+ * @return uint8_t Queued events (0 for an invalid actor)
+ */
+uint8_t actor_get_pending(uint8_t actor_id);
+
+#endif /* ACTOR_H */
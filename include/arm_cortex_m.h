@@ -9,6 +9,8 @@
 // Interrupt control and state register 
 #define NVIC_INT_CTRL_REG       (*((volatile uint32_t*)0xE000ED04))
 #define NVIC_PENDSVSET          0x10000000
+#define NVIC_PENDSTSET          0x04000000
+#define NVIC_PENDSTCLR          0x02000000
 
 // System control block registers
 #define NVIC_SYSPRI2_REG        (*((volatile uint32_t*)0xE000ED20))
@@ -28,4 +30,24 @@
 #define SYSTICK_CLKSOURCE       (1 << 2)
 #define SYSTICK_COUNTFLAG       (1 << 16)
 
+// Debug exception and monitor control, DWT cycle counter
+#define DEMCR_REG               (*((volatile uint32_t*)0xE000EDFC))
+#define DEMCR_TRCENA            (1 << 24)
+#define DWT_CTRL_REG            (*((volatile uint32_t*)0xE0001000))
+#define DWT_CYCCNT_REG          (*((volatile uint32_t*)0xE0001004))
+#define DWT_CTRL_CYCCNTENA      (1 << 0)
+#define DWT_CTRL_NOCYCCNT       (1 << 25)
+
+// ITM stimulus port 0 (printf viewer in the debugger)
+#define ITM_PORT0_REG           (*((volatile uint32_t*)0xE0000000))
+#define ITM_TER_REG             (*((volatile uint32_t*)0xE0000E00))
+#define ITM_TCR_REG             (*((volatile uint32_t*)0xE0000E80))
+#define ITM_TCR_ITMENA          (1 << 0)
+
+// Call fn with SP on stack_top (8-byte aligned, full descending)
+void cpu_run_on_stack(void (*fn)(void), uint32_t* stack_top);
+
+// Send a line plus newline to ITM port 0 (dropped while ITM is disabled)
+void cpu_itm_write_line(const char* line);
+
 #endif /* ARM_CORTEX_M_H */
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "rtos_config.h"
+
+/*
+ * Kernel micro-benchmarks (Rhealstone style)
+ *
+ * Each benchmark times one kernel path with time_now_cycles() - the DWT
+ * cycle counter on the target, CLOCK_MONOTONIC scaled to SYSTEM_CLOCK_HZ on
+ * the host port - and subtracts the cost of reading the clock:
+ *
+ *   task_switch        a task yields until the next task starts running
+ *   task_switch_ring   the same with every free task slot in the ring
+ *   scheduler_step     one scheduler_step() that dispatches a task which
+ *                      yields at once - the cost of the scheduling policy
+ *   preemption         an interrupt gives a semaphore until the waiting
+ *                      task runs (the interrupted task yields at once)
+ *   semaphore_shuffle  a task gives a semaphore until the waiting task runs
+ *   message_latency    queue_send() until queue_receive() in the next task
+ *   interrupt_latency  pending an interrupt until its handler starts
+ *   memory_alloc       memory_alloc() on a fragmented heap
+ *   memory_free        memory_free() of the same blocks (with merging)
+ *   memory_free_from_isr  the lock-free deferred free of such a block
+ *   task_churn         task_create() + task_delete() + reap
+ *
+ * Results are written as CSV so that two runs can be diffed with
+ * tools/bench/bench_compare.py.
+ */
+
+/* Benchmark configuration */
+#define BENCH_ITERATIONS        1000
+#define BENCH_WARMUP            8
+#define BENCH_MAX_RESULTS       12
+
+/* One benchmark result, in CPU cycles */
+typedef struct {
+    const char* name;
+    uint16_t tasks;             /* tasks in the ready ring during the run */
+    uint32_t iterations;        /* samples taken, 0 if the run failed */
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;      /* sum of all samples */
+} bench_result_t;
+
+/* Output sink for bench_write_csv(), called once per line (no newline) */
+typedef void (*bench_write_t)(const char* line);
+
+/**
+ * @brief Run all benchmarks
+ * @param results Array to fill
+ * @param max_results Size of the array (BENCH_MAX_RESULTS for all of them)
+ * @return uint16_t Number of results written, 0 if there is no cycle counter
+ * @note Call after memory_init(), task_manager_init() and scheduler_init(),
+ *       before any application task exists. Drives scheduler_step() itself
+ *       and leaves the scheduler as it found it. Uses the last semaphore
+ *       and the last queue ID.
+ */
+uint16_t bench_run_all(bench_result_t* results, uint16_t max_results);
+
+/**
+ * @brief Write results as CSV, header line first
+ * @param results Results from bench_run_all()
+ * @param count Number of results
+ * @param write Called once per line
+ */
+void bench_write_csv(const bench_result_t* results, uint16_t count, bench_write_t write);
+
+#endif /* BENCHMARK_H */
@@ -0,0 +1,120 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include "rtos_config.h"
+#include "task_manager.h"
+#include "scheduler.h"
+
+/*
+ * Coroutine tasks (protothread style)
+ *
+ * A coroutine is a stackless task whose function can stop in the middle
+ * and carry on from the same point on its next call. The resume point is a
+ * local continuation - the source line number - kept in a static variable
+ * and entered through a switch, so suspending is a store and a return and
+ * resuming is one jump.
+ *
+ *     void blink_task(void)
+ *     {
+ *         CO_BEGIN();
+ *         for (;;) {
+ *             led_toggle();
+ *             CO_DELAY(500);
+ *             CO_WAIT_UNTIL(button_pressed);
+ *         }
+ *         CO_END();
+ *     }
+ *
+ * Rules: local variables do not survive a CO_* point (use statics), CO_*
+ * macros cannot be used inside a switch of their own, and there can be at
+ * most one CO_* point per source line. One function is one coroutine.
+ */
+
+/* Local continuation: line to resume at, 0 = top of the function */
+typedef uint16_t co_state_t;
+
+/**
+ * @brief Start of the coroutine body
+ */
+#define CO_BEGIN()                                                  \
+    static co_state_t co_lc = 0;                                    \
+    switch (co_lc) {                                                \
+    case 0:
+
+/**
+ * @brief End of the coroutine body - the next call starts from the top
+ */
+#define CO_END()                                                    \
+    }                                                               \
+    co_lc = 0;                                                      \
+    return
+
+/**
+ * @brief Give up the rest of the time slice, continue here next turn
+ */
+#define CO_YIELD()                                                  \
+    do {                                                            \
+        co_lc = __LINE__;                                           \
+        scheduler_yield();                                          \
+        return;                                                     \
+    case __LINE__:;                                                 \
+    } while (0)
+
+/**
+ * @brief Continue only once cond is true, re-checked once per turn
+ */
+#define CO_WAIT_UNTIL(cond)                                         \
+    do {                                                            \
+        while (!(cond)) {                                           \
+            co_lc = __LINE__;                                       \
+            scheduler_yield();                                      \
+            return;                                                 \
+    case __LINE__:;                                                 \
+        }                                                           \
+    } while (0)
+
+/**
+ * @brief Sleep for a number of kernel ticks - the task is blocked, so it
+ *        takes no slices while it waits
+ */
+#define CO_DELAY(ticks)                                             \
+    do {                                                            \
+        co_lc = __LINE__;                                           \
+        coroutine_delay(ticks);                                     \
+        return;                                                     \
+    case __LINE__:                                                  \
+        coroutine_delay_done();                                     \
+    } while (0)
+
+/**
+ * @brief Call a kernel wait (e.g. semaphore_take) until it stops returning
+ *        RTOS_BLOCKED, then continue with its result in 'result'
+ */
+#define CO_AWAIT(result, call)                                      \
+    do {                                                            \
+        while (((result) = (call)) == RTOS_BLOCKED) {               \
+            co_lc = __LINE__;                                       \
+            return;                                                 \
+    case __LINE__:;                                                 \
+        }                                                           \
+    } while (0)
+
+/**
+ * @brief Create a coroutine task (stackless, runs on the scheduler's stack)
+ * @param task_function Function written with the CO_* macros
+ * @param task_name Task name
+ * @return task_id_t New task, or TASK_ID_INVALID
+ */
+task_id_t coroutine_create(void (*task_function)(void), const char* task_name);
+
+/**
+ * @brief Block the current task for a number of ticks (used by CO_DELAY)
+ */
+void coroutine_delay(uint32_t ticks);
+
+/**
+ * @brief Clear the finished delay of the current task (used by CO_DELAY)
+ */
+void coroutine_delay_done(void);
+
+#endif /* COROUTINE_H */
@@ -0,0 +1,75 @@
+#ifndef EVENT_GROUP_H
+#define EVENT_GROUP_H
+
+#include "rtos_config.h"
+
+/* Event group configuration */
+#define EVENT_GROUP_MAX_COUNT   4
+
+/* Wait options (may be OR'ed together) */
+#define EVENT_WAIT_ANY          0x00    /* Wake when any requested bit is set */
+#define EVENT_WAIT_ALL          0x01    /* Wake when all requested bits are set */
+#define EVENT_CLEAR_ON_EXIT     0x02    /* Clear the requested bits on wake-up */
+
+/**
+ * @brief Initialize event group subsystem
+ */
+void event_group_init(void);
+
+/**
+ * @brief Create an event group with all flags cleared
+ * @param group_id Event group identifier (0 to EVENT_GROUP_MAX_COUNT-1)
+ * @return rtos_result_t Success or error code
+ */
+rtos_result_t event_group_create(uint8_t group_id);
+
+/**
+ * @brief Set flags and wake every waiter whose condition is now met
+ * @param group_id Event group identifier
+ * @param bits Flags to set
+ * @return rtos_result_t Success or error code
+ * @note Safe to call from an ISR
+ */
+rtos_result_t event_group_set_bits(uint8_t group_id, uint32_t bits);
+
+/**
+ * @brief Clear flags
+ * @param group_id Event group identifier
+ * @param bits Flags to clear
+ * @return rtos_result_t Success or error code
+ */
+rtos_result_t event_group_clear_bits(uint8_t group_id, uint32_t bits);
+
+/**
+ * @brief Read the current flag word
+ * @param group_id Event group identifier
+ * @return uint32_t Current flags (0 for an invalid group)
+ */
+uint32_t event_group_get_bits(uint8_t group_id);
+
+/**
+ * @brief Wait for any/all of the given flags
+ * @param group_id Event group identifier
+ * @param bits Flags to wait for
+ * @param options EVENT_WAIT_ANY/EVENT_WAIT_ALL, optionally EVENT_CLEAR_ON_EXIT
+ * @param result_bits Receives the flag word at the moment the wait completed
+ * @return RTOS_SUCCESS when the condition is met, RTOS_BLOCKED if the calling
+ *         task has been blocked (return from the task function and call again
+ *         once scheduled to collect the result)
+ */
+rtos_result_t event_group_wait_bits(uint8_t group_id, uint32_t bits,
+                                    uint8_t options, uint32_t* result_bits);
+
+/**
+ * @brief Barrier: set own flags, then wait until all wait_bits are set
+ * @param group_id Event group identifier
+ * @param set_bits Flags contributed by the calling task
+ * @param wait_bits Flags of all parties taking part in the rendezvous
+ * @param result_bits Receives the flag word at the moment the barrier opened
+ * @return RTOS_SUCCESS when every party has arrived, RTOS_BLOCKED otherwise
+ * @note The wait_bits are cleared once the barrier opens so it can be reused
+ */
+rtos_result_t event_group_sync(uint8_t group_id, uint32_t set_bits,
+                               uint32_t wait_bits, uint32_t* result_bits);
+
+#endif /* EVENT_GROUP_H */
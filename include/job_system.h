@@ -0,0 +1,138 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "rtos_config.h"
+
+/*
+ * Fork-join job system
+ *
+ * Splits a block of work into small jobs without a task (and stack) per
+ * job. A fixed pool of JOB_WORKERS worker tasks runs them; each worker owns
+ * a Chase-Lev work-stealing deque, pushes and pops at its bottom end and
+ * steals from the top end of the others when its own is empty. Tasks
+ * outside the pool submit to one more deque that the workers steal from.
+ * A worker with nothing to run or steal blocks until the next submit wakes
+ * it, so idle workers leave lower priorities the CPU.
+ *
+ *     static job_range_t range;
+ *     static job_wait_group_t done;
+ *
+ *     job_wait_group_init(&done);
+ *     job_parallel_for(&range, 0, FRAME_LEN, 64, fir_filter_block, &frame, &done);
+ *     job_wait(&done);                    // helps run the jobs meanwhile
+ *
+ * A waiting task does not block: job_wait() runs queued jobs itself until
+ * the group is done. On a single core that means a fork-join runs straight
+ * through in the waiter, with no task switch per job; work submitted
+ * without waiting is picked up by the workers, one job per call, back to
+ * back within their slices.
+ *
+ * The deques are lock-free, so on the host port the pool can also run as
+ * JOB_WORKERS POSIX threads (JOB_HOST_THREADS) and spread a parallel_for
+ * across cores. Jobs must then not call other kernel services, which are
+ * single-threaded on the host.
+ *
+ * Jobs are submitted from task level (not from interrupts - use the work
+ * queue there) and must not block on kernel objects.
+ *
+ * The external deque has one owner end that all tasks outside the pool
+ * share. A Chase-Lev deque allows a single owner at a time: on the target
+ * the kernel guarantees that, since tasks only switch between calls and
+ * ISRs may not submit. A port that preempts tasks would need a deque per
+ * submitter or a lock; with host threads, threads outside the pool take
+ * a spinlock around their pushes and pops.
+ */
+
+/* Job system configuration */
+#ifndef JOB_WORKERS
+#define JOB_WORKERS             1       /* worker tasks (threads with JOB_HOST_THREADS) */
+#endif
+#define JOB_DEQUE_SIZE          64      /* jobs per deque, power of two */
+#define JOB_WORKER_STACK_SIZE   DEFAULT_STACK_SIZE
+
+/* Set to 1 on the host port to run the workers as POSIX threads */
+#ifndef JOB_HOST_THREADS
+#define JOB_HOST_THREADS        0
+#endif
+
+typedef void (*job_fn_t)(void* arg);
+typedef void (*job_range_fn_t)(uint32_t begin, uint32_t end, void* arg);
+
+/* Counts the jobs of a group that have not finished */
+typedef struct {
+    volatile uint32_t pending;
+} job_wait_group_t;
+
+/* Job - owned by the caller, must stay valid until its function has run */
+typedef struct {
+    job_fn_t fn;
+    void* arg;
+    job_wait_group_t* group;
+} job_t;
+
+/* State of one job_parallel_for() - owned by the caller like a job */
+typedef struct {
+    job_t jobs[JOB_WORKERS + 1];        /* one per worker plus the waiter */
+    job_range_fn_t fn;
+    void* arg;
+    volatile uint32_t next;             /* first index not yet handed out */
+    uint32_t end;
+    uint32_t grain;
+} job_range_t;
+
+/**
+ * @brief Create the worker tasks (or threads)
+ * @return rtos_result_t Success, or RTOS_NO_MEMORY if a worker could not
+ *         be created
+ */
+rtos_result_t job_system_init(void);
+
+#if RTOS_PORT_HOST && JOB_HOST_THREADS
+/**
+ * @brief Stop and join the worker threads once their deques are empty
+ */
+void job_system_shutdown(void);
+#endif
+
+/**
+ * @brief Set up an empty wait group
+ */
+void job_wait_group_init(job_wait_group_t* group);
+
+/**
+ * @brief Whether every job of the group has finished
+ */
+bool job_wait_group_done(const job_wait_group_t* group);
+
+/**
+ * @brief Queue a job
+ * @param job Storage for the job
+ * @param fn Function to run
+ * @param arg Passed to fn
+ * @param group Wait group to count the job in, or NULL
+ * @note From a worker the job goes on that worker's own deque. If the
+ *       deque is full the job runs at once, inside this call.
+ */
+void job_submit(job_t* job, job_fn_t fn, void* arg, job_wait_group_t* group);
+
+/**
+ * @brief Run fn over [begin, end) in chunks of grain indexes
+ * @param range Storage for the loop state
+ * @param grain Indexes per call of fn (0 is taken as 1)
+ * @note Queues one job per worker plus one for the waiter; each job takes
+ *       chunks from a shared counter until the range is used up, so the
+ *       chunks spread over whoever is free and there is no job per chunk.
+ */
+void job_parallel_for(job_range_t* range, uint32_t begin, uint32_t end, uint32_t grain,
+                      job_range_fn_t fn, void* arg, job_wait_group_t* group);
+
+/**
+ * @brief Run queued jobs until the group is done
+ * @return bool true when done; false if no queued job is left but the
+ *         group is not done - a job of it has not been submitted yet, or
+ *         is the caller itself. With host threads, jobs still running on
+ *         another thread are waited for.
+ */
+bool job_wait(job_wait_group_t* group);
+
+#endif /* JOB_SYSTEM_H */
@@ -10,6 +10,7 @@
 #define MIN_BLOCK_SIZE              16
 #define MEMORY_MAGIC_FREE           0xDEAD
 #define MEMORY_MAGIC_USED           0xBEEF
+#define MEMORY_MAGIC_DEFERRED       0xF5EE
 
 /* ============================================================================
  * MEMORY BLOCK STRUCTURE
@@ -24,6 +25,7 @@ typedef struct memory_block {
 /* ============================================================================
  * FUNCTION PROTOTYPES
  * ============================================================================ */
+#if RTOS_USE_HEAP
 
 /**
  * @brief Initialize the memory manager
@@ -40,5 +42,35 @@ void* memory_alloc(uint32_t size);
  */
 rtos_result_t memory_free(void* ptr);
 
+/**
+ * @brief Free a block from an ISR or from a task that does not own the heap
+ * @param ptr Pointer returned by memory_alloc()
+ * @return rtos_result_t RTOS_SUCCESS, RTOS_INVALID_PARAM or RTOS_ERROR (not
+ *         an allocated block, or already freed)
+ * @note Lock-free: the block is pushed onto a deferred list with one
+ *       compare-and-swap (LDREX/STREX on the target) and interrupts stay
+ *       enabled. It returns to the heap on the next memory_alloc() or when
+ *       the idle task calls memory_reclaim_deferred().
+ */
+rtos_result_t memory_free_from_isr(void* ptr);
+
+/**
+ * @brief Merge blocks freed with memory_free_from_isr() back into the heap
+ * @return uint32_t Number of blocks merged
+ */
+uint32_t memory_reclaim_deferred(void);
+
+/**
+ * @brief Get total size of all free blocks (bytes, headers included)
+ */
+uint32_t memory_get_free_size(void);
+
+/**
+ * @brief Get size of the largest free block (bytes, header included)
+ */
+uint32_t memory_get_largest_free_block(void);
+
+#endif /* RTOS_USE_HEAP */
+
 #endif /* MEMORY_MANAGER_H */
 
@@ -0,0 +1,76 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "rtos_config.h"
+#include "task_manager.h"
+
+/*
+ * PC-sampling profiler (RTOS_PROFILER)
+ *
+ * PROFILER_SAMPLE_HZ times a second, while a task's slice runs, the tick
+ * records the interrupted program counter and the current task ID in a
+ * ring. On the target the tick is the SysTick interrupt and the PC comes
+ * from the exception frame - on the task's PSP stack, or on MSP when the
+ * scheduler loop was interrupted. On the host port the tick is SIGPROF from
+ * setitimer() and the PC comes from the signal context.
+ *
+ * A task drains the ring with profiler_write(), one "task,pc" line per
+ * sample, and tools/profiler/prof_fold.py turns those lines into folded
+ * stacks ("task;function count") for flame graph tools.
+ */
+
+/* Profiler configuration */
+#define PROFILER_BUFFER_SIZE    128     /* samples, power of two */
+
+/* One sample */
+typedef struct {
+    uintptr_t pc;
+    task_id_t task_id;
+} profiler_sample_t;
+
+/* Output sink for profiler_write(), called once per line (no newline) */
+typedef void (*profiler_write_t)(const char* line);
+
+/**
+ * @brief Empty the ring, and on the host install the SIGPROF handler
+ */
+void profiler_init(void);
+
+/**
+ * @brief Start taking samples
+ */
+void profiler_start(void);
+
+/**
+ * @brief Stop taking samples (the ring keeps what it has)
+ */
+void profiler_stop(void);
+
+/**
+ * @brief Take samples out of the ring, oldest first
+ * @param samples Array to fill
+ * @param max_samples Size of the array
+ * @return uint16_t Number of samples copied
+ * @note One reader only; safe against the tick running meanwhile
+ */
+uint16_t profiler_read(profiler_sample_t* samples, uint16_t max_samples);
+
+/**
+ * @brief Samples lost because the ring was full
+ */
+uint32_t profiler_get_dropped(void);
+
+/**
+ * @brief Drain the ring as text: a "# profiler ..." header line, then one
+ *        "task_name,0xpc" line per sample (nothing if the ring is empty)
+ * @param write Called once per line
+ * @return uint16_t Number of samples written
+ */
+uint16_t profiler_write(profiler_write_t write);
+
+/**
+ * @brief Record one sample for the current task (called by the tick)
+ */
+void profiler_record(uintptr_t pc);
+
+#endif /* PROFILER_H */
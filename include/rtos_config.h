@@ -19,8 +19,13 @@
  * RTOS CONFIGURATION PARAMETERS
  * ============================================================================ */
 
-/* Maximum number of tasks */
+/* Maximum number of tasks (up to 1024, IDs are 16-bit) */
+#ifndef MAX_TASKS
 #define MAX_TASKS                   8
+#endif
+
+/* Name lookup hash buckets (power of two) */
+#define TASK_NAME_HASH_SIZE         16
 
 /* Maximum task name length */
 #define MAX_TASK_NAME_LENGTH        16
@@ -29,15 +34,90 @@
 #define MIN_STACK_SIZE              128
 #define DEFAULT_STACK_SIZE          256
 
+/* Stack profiling: paint new stacks so the unused part can be measured,
+ * and keep a guard word at the stack limit that the scheduler checks after
+ * every slice (0 to disable either) */
+#define RTOS_STACK_PAINT            1
+#define RTOS_STACK_GUARD            1
+#define STACK_PAINT_PATTERN         0xA5A5A5A5U
+#define STACK_GUARD_WORD            0xC0DEFACEU
+
+/* Headroom the stack report adds to the measured peak (bytes) - one
+ * exception frame is stacked on the task stack */
+#define STACK_REPORT_MARGIN         32
+
+/* CPU budgets: a task given one with task_set_budget() may run for at
+ * most that long per period and is skipped by the scheduler once it is
+ * used up, until the next period refills it (0 to disable). A call that
+ * runs on past the end of the budget is an overrun once it overshoots by
+ * more than TASK_BUDGET_SLACK_US. Without the DWT cycle counter the
+ * overshoot is measured with SysTick, which sees at most one more slice
+ * per call - a longer overrun is charged short */
+#ifndef RTOS_TASK_BUDGET
+#define RTOS_TASK_BUDGET            1
+#endif
+#define TASK_BUDGET_SLACK_US        20
+/* Shortest slice a budget is cut to; less than this left counts as used
+ * up (a 1-cycle slice would program SysTick with LOAD = 0) */
+#define TASK_BUDGET_MIN_SLICE_US    10
+
+/* Scheduling policy, fixed at build time (see sched_policy.h):
+ * round-robin, fixed priority, or priority with round-robin among equals */
+#define SCHED_POLICY_RR             0
+#define SCHED_POLICY_FIXED_PRIORITY 1
+#define SCHED_POLICY_PRIORITY_RR    2
+#ifndef RTOS_SCHED_POLICY
+#define RTOS_SCHED_POLICY           SCHED_POLICY_RR
+#endif
+
 /* Time slice for round-robin scheduling (in ms) */
 #define TIME_SLICE_MS               10
 
+/* Kernel tick rate used for timeouts (Hz) */
+#define RTOS_TICK_RATE_HZ           1000
+
+/* Timeout value meaning "wait until the object becomes available" */
+#define RTOS_WAIT_FOREVER           0xFFFFFFFFU
+
+/* Task priorities - higher value is more important */
+#define TASK_PRIORITY_IDLE          0
+#define DEFAULT_TASK_PRIORITY       1
+#define MAX_TASK_PRIORITY           7
+
 /* System clock frequency (Hz) */
 #define SYSTEM_CLOCK_HZ             48000000
 
 /* Memory configuration */
 #define HEAP_SIZE                   4096
 
+/* Set to 1 (e.g. -DRTOS_PORT_HOST=1) when building kernel code for the host */
+#ifndef RTOS_PORT_HOST
+#define RTOS_PORT_HOST              0
+#endif
+
+/* Set to 0 for a fully static system: no heap, only task_create_static() */
+#define RTOS_USE_HEAP               1
+
+/* Set to 1 to build the kernel micro-benchmarks (benchmark.c). main() then
+ * runs them once before the demo tasks and writes the results to ITM */
+#ifndef RTOS_BENCHMARK
+#define RTOS_BENCHMARK              0
+#endif
+
+/* Set to 1 for the PC-sampling profiler (profiler.c). SysTick then
+ * interrupts PROFILER_SAMPLE_HZ times a second during each slice and
+ * counts the slice down, instead of being polled */
+#ifndef RTOS_PROFILER
+#define RTOS_PROFILER               0
+#endif
+#define PROFILER_SAMPLE_HZ          1000
+
+/* Set to 1 to build the task set from task_config.h at compile time */
+#define RTOS_STATIC_TASK_TABLE      0
+
+/* RAM allowed for the compile-time task set (stacks + TCBs, bytes) */
+#define STATIC_TASK_RAM_BUDGET      4096
+
 /* ============================================================================
  * TASK STATES
  * ============================================================================ */
@@ -57,14 +137,21 @@ typedef enum {
     RTOS_ERROR = -1,
     RTOS_TIMEOUT = -2,
     RTOS_NO_MEMORY = -3,
-    RTOS_INVALID_PARAM = -4
+    RTOS_INVALID_PARAM = -4,
+    RTOS_BLOCKED = -5
 } rtos_result_t;
 
 /* ============================================================================
  * CRITICAL SECTION MACROS
  * ============================================================================ */
+#if RTOS_PORT_HOST
+/* Host builds are single-threaded simulations */
+#define ENTER_CRITICAL()            do { } while(0)
+#define EXIT_CRITICAL()             do { } while(0)
+#else
 #define ENTER_CRITICAL()            __disable_irq()
 #define EXIT_CRITICAL()             __enable_irq()
+#endif
 
 /* ============================================================================
  * DEBUG MACROS
@@ -0,0 +1,256 @@
+#ifndef SCHED_POLICY_H
+#define SCHED_POLICY_H
+
+#include "rtos_config.h"
+#include "task_manager.h"
+
+/*
+ * Scheduling policies (RTOS_SCHED_POLICY)
+ *
+ * scheduler.c keeps its tasks in a sched_queue_t and drives it through
+ * five operations:
+ *
+ *   sched_policy_enqueue    a task joins the scheduler (created)
+ *   sched_policy_dequeue    a task leaves it (deleted, or re-prioritized)
+ *   sched_policy_pick_next  the task to run now and its slice length
+ *   sched_policy_tick       the task ran its slice to the end
+ *   sched_policy_yield      the task yielded or blocked before the end
+ *
+ * Each policy below provides them as static inline functions and only the
+ * configured one is compiled, so they inline into scheduler_step() - there
+ * is no table of function pointers to call through.
+ *
+ *   SCHED_POLICY_RR              one ring in creation order, priorities
+ *                                are ignored (the original scheduler)
+ *   SCHED_POLICY_FIXED_PRIORITY  the highest-priority runnable task runs;
+ *                                it keeps the CPU across slices until it
+ *                                blocks or yields, then goes behind the
+ *                                other tasks of its priority
+ *   SCHED_POLICY_PRIORITY_RR     the same, but equal priorities also take
+ *                                turns at the end of every slice
+ *
+ * Blocked and suspended tasks stay queued and are passed over, as are
+ * tasks that have used up their CPU budget. Private to scheduler.c.
+ */
+
+#if RTOS_SCHED_POLICY == SCHED_POLICY_RR
+#define SCHED_POLICY_LEVELS     1
+#elif RTOS_SCHED_POLICY == SCHED_POLICY_FIXED_PRIORITY || \
+      RTOS_SCHED_POLICY == SCHED_POLICY_PRIORITY_RR
+#define SCHED_POLICY_LEVELS     (MAX_TASK_PRIORITY + 1)
+#else
+#error "RTOS_SCHED_POLICY must be SCHED_POLICY_RR, _FIXED_PRIORITY or _PRIORITY_RR"
+#endif
+
+#if SCHED_POLICY_LEVELS > 32
+#error "Priority policies support at most 32 priority levels"
+#endif
+
+/* Ready queue: one ring per priority level, linked through tcb->next/prev */
+typedef struct {
+    tcb_t* ring[SCHED_POLICY_LEVELS];   /* first task to consider, NULL if empty */
+    uint32_t levels;                    /* bit p set = ring[p] is not empty */
+} sched_queue_t;
+
+/* ============================================================================
+ * COMMON HELPERS
+ * ============================================================================ */
+
+/**
+ * @brief Slice a task may run now: slice_cycles, capped by its CPU budget
+ * @return uint32_t 0 if the task cannot run (blocked, suspended, throttled)
+ */
+static inline uint32_t sched_policy_slice(tcb_t* tcb, uint32_t slice_cycles, uint32_t now)
+{
+    if (tcb->state == TASK_STATE_BLOCKED || tcb->state == TASK_STATE_SUSPENDED) {
+        return 0U;
+    }
+#if RTOS_TASK_BUDGET
+    return task_budget_slice(tcb, slice_cycles, now);
+#else
+    (void)now;
+    return slice_cycles;
+#endif
+}
+
+/**
+ * @brief Link a task in at the back of a ring (just before its first task)
+ */
+static inline void sched_ring_append(tcb_t** ring, tcb_t* tcb)
+{
+    tcb_t* first = *ring;
+
+    if (first == NULL) {
+        *ring = tcb;
+        tcb->next = tcb;
+        tcb->prev = tcb;
+    } else {
+        tcb_t* last = first->prev;
+        tcb->next = first;
+        tcb->prev = last;
+        last->next = tcb;
+        first->prev = tcb;
+    }
+}
+
+/**
+ * @brief Unlink a task from a ring
+ * @param resume Where the ring continues if tcb was its first task
+ */
+static inline void sched_ring_unlink(tcb_t** ring, tcb_t* tcb, tcb_t* resume)
+{
+    if (tcb->next == tcb) {
+        *ring = NULL;
+    } else {
+        tcb->prev->next = tcb->next;
+        tcb->next->prev = tcb->prev;
+        if (*ring == tcb) {
+            *ring = resume;
+        }
+    }
+    tcb->next = NULL;
+    tcb->prev = NULL;
+}
+
+static inline void sched_policy_init(sched_queue_t* q)
+{
+    memset(q, 0, sizeof(*q));
+}
+
+#if RTOS_SCHED_POLICY == SCHED_POLICY_RR
+/* ============================================================================
+ * ROUND-ROBIN
+ * ============================================================================ */
+/* ring[0] is the task whose turn it is; every slice ends by moving on */
+
+static inline void sched_policy_enqueue(sched_queue_t* q, tcb_t* tcb)
+{
+    sched_ring_append(&q->ring[0], tcb);
+    q->levels = 1U;
+}
+
+static inline void sched_policy_dequeue(sched_queue_t* q, tcb_t* tcb)
+{
+    /* Step back, so moving on continues with the task after the removed one */
+    sched_ring_unlink(&q->ring[0], tcb, tcb->prev);
+    if (q->ring[0] == NULL) {
+        q->levels = 0U;
+    }
+}
+
+/**
+ * @brief The task whose turn it is, or NULL if it cannot run (its turn is
+ *        then passed on, one task per call as before)
+ */
+static inline tcb_t* sched_policy_pick_next(sched_queue_t* q, uint32_t now, uint32_t* slice)
+{
+    tcb_t* tcb = q->ring[0];
+
+    if (tcb == NULL) {
+        return NULL;
+    }
+    *slice = sched_policy_slice(tcb, *slice, now);
+    if (*slice == 0U) {
+        q->ring[0] = tcb->next;
+        return NULL;
+    }
+    return tcb;
+}
+
+static inline void sched_policy_tick(sched_queue_t* q, tcb_t* tcb)
+{
+    (void)tcb;
+    if (q->ring[0] != NULL) {
+        q->ring[0] = q->ring[0]->next;
+    }
+}
+
+static inline void sched_policy_yield(sched_queue_t* q, tcb_t* tcb)
+{
+    sched_policy_tick(q, tcb);
+}
+
+#else
+/* ============================================================================
+ * FIXED PRIORITY / PRIORITY + ROUND-ROBIN
+ * ============================================================================ */
+/* ring[p] is the front of priority p's queue, levels has a bit per
+ * non-empty ring so the highest one is a single CLZ */
+
+static inline void sched_policy_enqueue(sched_queue_t* q, tcb_t* tcb)
+{
+    sched_ring_append(&q->ring[tcb->priority], tcb);
+    q->levels |= 1U << tcb->priority;
+}
+
+static inline void sched_policy_dequeue(sched_queue_t* q, tcb_t* tcb)
+{
+    uint8_t priority = tcb->priority;
+
+    sched_ring_unlink(&q->ring[priority], tcb, tcb->next);
+    if (q->ring[priority] == NULL) {
+        q->levels &= ~(1U << priority);
+    }
+}
+
+/**
+ * @brief The first runnable task of the highest priority that has one,
+ *        NULL if no task can run
+ * @note Blocked tasks are passed over one by one, so the cost grows with
+ *       the number of blocked tasks above the one that runs
+ */
+static inline tcb_t* sched_policy_pick_next(sched_queue_t* q, uint32_t now, uint32_t* slice)
+{
+    uint32_t levels = q->levels;
+
+    while (levels != 0U) {
+        uint32_t priority = 31U - (uint32_t)__builtin_clz(levels);
+        tcb_t* first = q->ring[priority];
+        tcb_t* tcb = first;
+
+        do {
+            uint32_t granted = sched_policy_slice(tcb, *slice, now);
+            if (granted != 0U) {
+                *slice = granted;
+                return tcb;
+            }
+            tcb = tcb->next;
+        } while (tcb != first);
+        levels &= ~(1U << priority);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Put a task behind the others of its priority
+ */
+static inline void sched_policy_yield(sched_queue_t* q, tcb_t* tcb)
+{
+    tcb_t** ring = &q->ring[tcb->priority];
+
+    /* A task deleted during its slice has already left the queue */
+    if (tcb->state == TASK_STATE_DELETED) {
+        return;
+    }
+    if (*ring == tcb) {
+        /* Rotating the ring puts the first task last */
+        *ring = tcb->next;
+    } else if ((*ring)->prev != tcb) {
+        sched_ring_unlink(ring, tcb, tcb->next);
+        sched_ring_append(ring, tcb);
+    }
+}
+
+static inline void sched_policy_tick(sched_queue_t* q, tcb_t* tcb)
+{
+#if RTOS_SCHED_POLICY == SCHED_POLICY_PRIORITY_RR
+    sched_policy_yield(q, tcb);
+#else
+    /* Keeps its place - runs again while it is the first runnable task */
+    (void)q;
+    (void)tcb;
+#endif
+}
+#endif
+
+#endif /* SCHED_POLICY_H */
@@ -11,12 +11,28 @@ rtos_result_t scheduler_init(void);
 
 rtos_result_t scheduler_add_ready_task(tcb_t* tcb);
 
+rtos_result_t scheduler_remove_task(tcb_t* tcb);
+
+ // Change a task's priority, moving it within the ready queue if the
+ // policy orders by priority (called by task_set_priority())
+void scheduler_set_task_priority(tcb_t* tcb, uint8_t priority);
+
 bool scheduler_is_running(void);
 
 void scheduler_idle_task(void);
 
-uint8_t scheduler_add_task_fn(scheduler_task_fn_t fn, const char* name, uint32_t stack_size);
+void scheduler_yield(void);
+
+#if RTOS_USE_HEAP
+task_id_t scheduler_add_task_fn(scheduler_task_fn_t fn, const char* name, uint32_t stack_size);
+#endif
 
 void scheduler_run(void);
 
+ // One pass of the scheduling loop: pick the next task and run its slice
+ // (scheduler_run() = scheduler_start() + scheduler_step() forever)
+void scheduler_step(void);
+
+void scheduler_start(void);
+
 #endif 
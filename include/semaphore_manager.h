@@ -0,0 +1,57 @@
+#ifndef SEMAPHORE_MANAGER_H
+#define SEMAPHORE_MANAGER_H
+
+#include "rtos_config.h"
+
+/* Semaphore configuration */
+#define SEMAPHORE_MAX_COUNT     4
+
+/**
+ * @brief Initialize semaphore subsystem
+ */
+void semaphore_init(void);
+
+/**
+ * @brief Create a counting semaphore
+ * @param sem_id Semaphore identifier (0 to SEMAPHORE_MAX_COUNT-1)
+ * @param initial_count Tokens available after creation
+ * @param max_count Upper bound on the token count
+ * @return rtos_result_t Success or error code
+ */
+rtos_result_t semaphore_create(uint8_t sem_id, uint32_t initial_count, uint32_t max_count);
+
+/**
+ * @brief Create a binary semaphore (max_count of 1)
+ * @param sem_id Semaphore identifier
+ * @param available true to create it in the given state
+ * @return rtos_result_t Success or error code
+ */
+rtos_result_t semaphore_create_binary(uint8_t sem_id, bool available);
+
+/**
+ * @brief Take a token
+ * @param sem_id Semaphore identifier
+ * @param timeout_ticks 0 to poll, RTOS_WAIT_FOREVER, or a tick count
+ * @return RTOS_SUCCESS when a token was taken, RTOS_TIMEOUT when none was
+ *         available in time, RTOS_BLOCKED if the calling task has been
+ *         blocked (return from the task function and call again once
+ *         scheduled to collect the result)
+ */
+rtos_result_t semaphore_take(uint8_t sem_id, uint32_t timeout_ticks);
+
+/**
+ * @brief Give a token, handing it to the highest-priority waiter if any
+ * @param sem_id Semaphore identifier
+ * @return rtos_result_t Success, or RTOS_ERROR if the count is at its maximum
+ * @note Safe to call from an ISR
+ */
+rtos_result_t semaphore_give(uint8_t sem_id);
+
+/**
+ * @brief Read the current token count
+ * @param sem_id Semaphore identifier
+ * @return uint32_t Available tokens (0 for an invalid or uncreated semaphore)
+ */
+uint32_t semaphore_get_count(uint8_t sem_id);
+
+#endif /* SEMAPHORE_MANAGER_H */
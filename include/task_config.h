@@ -0,0 +1,25 @@
+
+ // Compile-time task set, used when RTOS_STATIC_TASK_TABLE is 1.
+ // task_manager.c expands RTOS_TASK_LIST into fully initialized TCBs, their
+ // stacks and a pre-linked ready ring, so main() only calls scheduler_run().
+ // The idle task is added in front of the list automatically.
+
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+#include "rtos_config.h"
+
+ // Task functions referenced by the table
+
+void task1(void);
+void task2(void);
+void task3(void);
+
+ // TASK(name, function, stack_size_bytes, priority)
+
+#define RTOS_TASK_LIST(TASK)                                        \
+    TASK(Task1, task1, DEFAULT_STACK_SIZE, DEFAULT_TASK_PRIORITY)   \
+    TASK(Task2, task2, DEFAULT_STACK_SIZE, DEFAULT_TASK_PRIORITY)   \
+    TASK(Task3, task3, DEFAULT_STACK_SIZE, DEFAULT_TASK_PRIORITY)
+
+#endif /* TASK_CONFIG_H */
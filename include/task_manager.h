@@ -7,19 +7,91 @@
 
 #include "rtos_config.h"
 
+ // TASK ID - index into the task table, TASK_ID_INVALID when none
+
+typedef uint16_t task_id_t;
+
+#define TASK_ID_INVALID             0xFFFF
+
+ // TASK BUDGET - CPU time a task may use per period (RTOS_TASK_BUDGET)
+ // The part every dispatch reads; it sits in the TCB right after the
+ // dispatch fields. The overrun statistics are cold and live in task_info_t.
+
+typedef struct {
+    uint32_t budget;            // cycles per period, 0 = no budget
+    uint32_t period;            // kernel ticks
+    int32_t remaining;          // cycles left this period, < 0 = owed after an overrun
+    uint32_t next_refill;       // tick of the next replenishment
+    bool throttled;             // out of budget until next_refill
+} task_budget_t;
+
+typedef struct {
+    uint32_t exhausted;         // periods in which the budget ran out
+    uint32_t overruns;          // calls that ran past the budget (beyond the slack)
+    uint32_t overrun_max;       // largest overshoot seen, cycles
+} task_budget_stats_t;
+
  // TASK CONTROL BLOCK (TCB) STRUCTURE
+ // Hot part only: the fields the dispatch path reads come first and fit in
+ // one 20-byte record on the Cortex-M3 (four pointers, the ID, state and
+ // priority - task_manager.c checks this). state holds a task_state_t in a
+ // byte, since an enum would take a word. Rarely used data lives in
+ // task_info_t.
 
 typedef struct task_control_block {
-    uint8_t task_id;
-    char task_name[MAX_TASK_NAME_LENGTH];
+    struct task_control_block* next;
+    struct task_control_block* prev;
     void (*task_function)(void);
-    task_state_t state;
     uint32_t* stack_pointer;
+    task_id_t task_id;
+    uint8_t state;              // task_state_t
+    uint8_t priority;
+#if RTOS_TASK_BUDGET
+    task_budget_t budget;
+#endif
+    uint8_t wait_options;
+    bool wait_timed;
+    rtos_result_t wait_result;
+    void* wait_object;
+    uint32_t wait_value;
+    uint32_t wake_tick;
+    struct task_wait_list* wait_list;
+    struct task_control_block* wait_next;
+    struct task_control_block* wait_prev;
+} tcb_t;
+
+ // TASK INFO - cold per-task data, same index as the TCB
+
+typedef struct {
+    char task_name[MAX_TASK_NAME_LENGTH];
     uint32_t* stack_base;
     uint32_t stack_size;
-    struct task_control_block* next;
-    struct task_control_block* prev;
-} tcb_t;
+    bool stack_static;
+    bool stack_overflow;
+    task_id_t name_next;
+    task_id_t name_prev;
+#if RTOS_TASK_BUDGET
+    task_budget_stats_t budget;
+#endif
+} task_info_t;
+
+ // WAIT LIST - tasks blocked on a kernel object, highest priority first
+
+typedef struct task_wait_list {
+    tcb_t* head;
+    tcb_t* tail;
+} task_wait_list_t;
+
+ // STACK REPORT - one entry per task, sizes in bytes
+
+typedef struct {
+    task_id_t task_id;
+    const char* task_name;
+    uint32_t stack_size;
+    uint32_t stack_used;
+    uint32_t stack_recommended;
+    bool stack_overflow;
+} task_stack_report_t;
 
  // FUNCTION PROTOTYPES
 
@@ -28,22 +100,108 @@ typedef struct task_control_block {
 rtos_result_t task_manager_init(void);
  //Create a new task
  
-uint8_t task_create(void (*task_function)(void), 
-                   const char* task_name, 
-                   uint32_t stack_size);
+#if RTOS_USE_HEAP
+task_id_t task_create(void (*task_function)(void),
+                      const char* task_name,
+                      uint32_t stack_size);
+#endif
+
+ //Create a new task on a caller-supplied stack (stack_size in bytes)
+ 
+task_id_t task_create_static(void (*task_function)(void),
+                             const char* task_name,
+                             uint32_t* stack,
+                             uint32_t stack_size);
+
+ //Create a task that runs on the scheduler's stack (no stack of its own)
+ 
+task_id_t task_create_stackless(void (*task_function)(void),
+                                const char* task_name);
+
+ //Delete a task (stack and ID are reclaimed later by the idle task; until
+ //then they do not count as free for task_create*())
+ 
+rtos_result_t task_delete(task_id_t task_id);
+
+ //Reclaim stacks and IDs of deleted tasks (idle task, or outside any task)
+ 
+void task_reap_deleted(void);
+
 //Get task control block by ID
  
-tcb_t* task_get_tcb(uint8_t task_id);
+tcb_t* task_get_tcb(task_id_t task_id);
+
+ //Get cold task data (name, stack) by ID
+ 
+task_info_t* task_get_info(task_id_t task_id);
+
+ //Find a task by name (O(1) average, hashed)
+ 
+task_id_t task_find_by_name(const char* task_name);
 
 // Get current running task
  
 tcb_t* task_get_current(void);
  //Set task state
  
-rtos_result_t task_set_state(uint8_t task_id, task_state_t new_state);
+rtos_result_t task_set_state(task_id_t task_id, task_state_t new_state);
+
+ //Set task priority (0..MAX_TASK_PRIORITY)
+ 
+rtos_result_t task_set_priority(task_id_t task_id, uint8_t priority);
 
 //Get number of active tasks
  
-uint8_t task_get_count(void);
+uint16_t task_get_count(void);
+
+ //Peak stack use of a task in bytes, measured from the painted stack
+ 
+uint32_t task_get_stack_high_water(task_id_t task_id);
+
+ //Check the guard word after a slice; suspends the task if it was overwritten
+ 
+bool task_check_stack_guard(tcb_t* tcb);
+
+ //Fill report with peak use and a recommended stack size for every task
+ 
+uint16_t task_stack_report(task_stack_report_t* report, uint16_t max_entries);
+
+#if RTOS_TASK_BUDGET
+ //Give a task budget_us of CPU time every period_ticks (budget_us 0 removes it,
+ //otherwise at least TASK_BUDGET_MIN_SLICE_US)
+ 
+rtos_result_t task_set_budget(task_id_t task_id, uint32_t budget_us, uint32_t period_ticks);
+
+ //Slice length for a task at tick 'now': slice_cycles capped by what is
+ //left of its budget, 0 while it is throttled or less than the minimum
+ //slice is left
+ 
+uint32_t task_budget_slice(tcb_t* tcb, uint32_t slice_cycles, uint32_t now);
+
+ //Charge the cycles a slice used to the task's budget
+ 
+void task_budget_charge(tcb_t* tcb, uint32_t used_cycles);
+#endif
+
+ //Initialize an empty wait list
+ 
+void task_wait_list_init(task_wait_list_t* list);
+
+ //Block the current task on a wait list (call with interrupts disabled)
+ 
+rtos_result_t task_block_current(task_wait_list_t* list, void* wait_object,
+                                 uint32_t timeout_ticks);
+
+ //Remove a task from its wait list and make it ready (call with interrupts disabled)
+ 
+void task_wake(tcb_t* tcb, rtos_result_t result);
+
+ //Collect the result of a finished wait on wait_object for the current task
+ 
+bool task_wait_complete(void* wait_object, rtos_result_t* result);
+
+ //Wake blocked tasks whose timeout has expired at tick 'now'
+ 
+void task_check_timeouts(uint32_t now);
 
 #endif /* TASK_MANAGER_H */
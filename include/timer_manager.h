@@ -4,6 +4,14 @@
 
 #include "rtos_config.h"
 
+/* Software timer configuration */
+#define SOFT_TIMER_MAX_COUNT        8
+#define SOFT_TIMER_CMD_QUEUE_SIZE   8
+#define SOFT_TIMER_STACK_SIZE       DEFAULT_STACK_SIZE
+
+/* Software timer callback, runs on the timer daemon's stack */
+typedef void (*soft_timer_callback_t)(uint8_t timer_id, void* arg);
+
 /* FUNCTION PROTOTYPES - TIMING UTILITIES*/
 
 
@@ -26,5 +34,74 @@ void timer_stop_slice(void);
  
 bool timer_slice_expired(void);
 
+//Count one sample period of the running slice - called by the SysTick
+//handler in RTOS_PROFILER builds, where the slice is interrupt driven
+ 
+void timer_slice_tick(void);
+
+//Get kernel tick count (RTOS_TICK_RATE_HZ), advanced by the CPU time
+//consumed in each slice
+ 
+uint32_t timer_get_tick_count(void);
+
+/* FUNCTION PROTOTYPES - TIMEBASE*/
+
+//Start the 64-bit timebase (DWT cycle counter if present, otherwise the
+//slice timer, which only counts time inside slices and misses whole
+//slices of a call that overruns its slice by more than one).
+//Called by scheduler_start()
+ 
+void timer_timebase_init(void);
+
+//Monotonic time in CPU cycles since timer_timebase_init(), never wraps
+//Safe from tasks and interrupts without a critical section
+ 
+uint64_t time_now_cycles(void);
+
+//Monotonic time in kernel ticks (RTOS_TICK_RATE_HZ), never wraps
+ 
+uint64_t time_now_ticks64(void);
+
+//Conversions for intervals up to 2^32 cycles - fixed-point multiply,
+//no division at run time
+ 
+uint32_t time_cycles_to_us(uint32_t cycles);
+uint32_t time_us_to_cycles(uint32_t us);
+uint32_t time_cycles_to_ticks(uint32_t cycles);
+uint32_t time_ticks_to_cycles(uint32_t ticks);
+
+/* FUNCTION PROTOTYPES - SOFTWARE TIMERS*/
+
+//Reset all timers and create the timer daemon task
+ 
+rtos_result_t soft_timer_init(void);
+
+//Configure a timer (stopped). period_ticks in kernel ticks, > 0
+ 
+rtos_result_t soft_timer_create(uint8_t timer_id, uint32_t period_ticks, bool periodic,
+                                soft_timer_callback_t callback, void* arg);
+
+//Start a stopped timer, first expiry one period from now
+ 
+rtos_result_t soft_timer_start(uint8_t timer_id);
+
+//Stop a timer, a pending expiry is dropped
+ 
+rtos_result_t soft_timer_stop(uint8_t timer_id);
+
+//Restart the period from now (starts the timer if stopped)
+ 
+rtos_result_t soft_timer_reset(uint8_t timer_id);
+
+//ISR versions - queued for the daemon, period counts from the call
+ 
+rtos_result_t soft_timer_start_from_isr(uint8_t timer_id);
+rtos_result_t soft_timer_stop_from_isr(uint8_t timer_id);
+rtos_result_t soft_timer_reset_from_isr(uint8_t timer_id);
+
+//True while the timer is started
+ 
+bool soft_timer_is_active(uint8_t timer_id);
+
 #endif 
 
@@ -0,0 +1,72 @@
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include "rtos_config.h"
+
+/*
+ * Deferred work queue (bottom halves)
+ *
+ * An ISR does the minimum - read the device, clear the interrupt - and
+ * posts a work item. The work function then runs at task level in the
+ * kernel worker task, so interrupts stay enabled while it runs and other
+ * ISRs keep their latency.
+ *
+ *     static work_item_t rx_work;
+ *
+ *     void UART0_IRQHandler(void)
+ *     {
+ *         uart_ack_irq();
+ *         work_post(&rx_work);            // no-op if already queued
+ *     }
+ *
+ *     work_init(&rx_work, uart_rx_process, &uart0);
+ *
+ * Posting takes no lock: one atomic exchange for the pending flag and a
+ * compare-and-swap loop for the list (LDREX/STREX on the target), so any
+ * number of ISRs and tasks may post at once. Only a post to an empty queue
+ * disables interrupts, briefly, to wake the sleeping worker.
+ */
+
+/* Work queue configuration */
+#define WORK_QUEUE_STACK_SIZE   DEFAULT_STACK_SIZE
+
+typedef void (*work_fn_t)(void* arg);
+
+/* Work item - owned by the caller, must stay valid while posted */
+typedef struct work_item {
+    struct work_item* volatile next;
+    work_fn_t fn;
+    void* arg;
+    volatile uint32_t pending;  /* 1 from work_post() until fn is called */
+} work_item_t;
+
+/**
+ * @brief Create the worker task
+ * @return rtos_result_t Success, or RTOS_NO_MEMORY if no task slot is free
+ */
+rtos_result_t work_queue_init(void);
+
+/**
+ * @brief Set up a work item (not posted)
+ * @param work Item to set up
+ * @param fn Function the worker calls
+ * @param arg Passed to fn
+ */
+void work_init(work_item_t* work, work_fn_t fn, void* arg);
+
+/**
+ * @brief Queue a work item
+ * @param work Item set up with work_init()
+ * @return bool true if queued, false if it was already pending (the
+ *         posts coalesce into one call)
+ * @note Safe from any ISR or task. The pending flag is cleared just before
+ *       fn runs, so a post made while fn runs queues it again.
+ */
+bool work_post(work_item_t* work);
+
+/**
+ * @brief Whether a work item is queued and not yet started
+ */
+bool work_is_pending(const work_item_t* work);
+
+#endif /* WORK_QUEUE_H */
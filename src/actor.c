@@ -0,0 +1,211 @@
+#include "actor.h"
+#include "task_manager.h"
+#include "arm_cortex_m.h"
+
+#if ACTOR_MAX_COUNT > 32
+#error "Actor ready masks support at most 32 actors"
+#endif
+
+/* ============================================================================
+ * PRIVATE DATA STRUCTURES
+ * ============================================================================ */
+typedef struct {
+    actor_handler_t  handler;
+    actor_event_t    queue[ACTOR_QUEUE_SIZE];
+    uint8_t          head;
+    uint8_t          count;
+    uint8_t          priority;
+} actor_t;
+
+static actor_t actors[ACTOR_MAX_COUNT];
+
+/* Bit n of actor_ready[p] set = actor n (priority p) has events queued;
+ * bit p of actor_ready_prios set = actor_ready[p] is not empty */
+static uint32_t actor_ready[MAX_TASK_PRIORITY + 1];
+static uint32_t actor_ready_prios = 0;
+static uint8_t actor_last[MAX_TASK_PRIORITY + 1];
+
+static task_wait_list_t actor_wait;
+static uint32_t actor_stack[ACTOR_STACK_SIZE / sizeof(uint32_t)];
+static task_id_t actor_task = TASK_ID_INVALID;
+
+/* ============================================================================
+ * PRIVATE FUNCTION PROTOTYPES
+ * ============================================================================ */
+static actor_t* actor_get(uint8_t actor_id);
+static uint8_t actor_next_ready(uint8_t priority);
+static void actor_dispatcher(void);
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Reset all actors and create the dispatcher task
+ */
+rtos_result_t actor_init(void)
+{
+    memset(actors, 0, sizeof(actors));
+    memset(actor_ready, 0, sizeof(actor_ready));
+    memset(actor_last, 0, sizeof(actor_last));
+    actor_ready_prios = 0;
+    task_wait_list_init(&actor_wait);
+
+    if (actor_task == TASK_ID_INVALID) {
+        actor_task = task_create_static(actor_dispatcher, "Actors",
+                                        actor_stack, sizeof(actor_stack));
+        if (actor_task == TASK_ID_INVALID) {
+            return RTOS_NO_MEMORY;
+        }
+    }
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Create an actor
+ */
+rtos_result_t actor_create(uint8_t actor_id, actor_handler_t handler, uint8_t priority)
+{
+    if (actor_id >= ACTOR_MAX_COUNT || handler == NULL || priority > MAX_TASK_PRIORITY) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    actor_t* actor = &actors[actor_id];
+
+    ENTER_CRITICAL();
+    /* Drop events queued under an earlier priority */
+    if (actor->count != 0) {
+        actor_ready[actor->priority] &= ~(1UL << actor_id);
+        if (actor_ready[actor->priority] == 0) {
+            actor_ready_prios &= ~(1UL << actor->priority);
+        }
+    }
+    actor->handler = handler;
+    actor->priority = priority;
+    actor->head = 0;
+    actor->count = 0;
+    EXIT_CRITICAL();
+
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Queue an event for an actor
+ */
+rtos_result_t actor_post(uint8_t actor_id, uint16_t signal, uint32_t param)
+{
+    actor_t* actor = actor_get(actor_id);
+
+    if (actor == NULL) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    ENTER_CRITICAL();
+
+    if (actor->count >= ACTOR_QUEUE_SIZE) {
+        EXIT_CRITICAL();
+        return RTOS_NO_MEMORY;
+    }
+
+    actor_event_t* event = &actor->queue[(actor->head + actor->count) % ACTOR_QUEUE_SIZE];
+    event->signal = signal;
+    event->param = param;
+    actor->count++;
+
+    actor_ready[actor->priority] |= (1UL << actor_id);
+    actor_ready_prios |= (1UL << actor->priority);
+
+    /* Dispatcher sleeps while no actor has work */
+    if (actor_wait.head != NULL) {
+        task_wake(actor_wait.head, RTOS_SUCCESS);
+    }
+
+    EXIT_CRITICAL();
+
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Number of events waiting for an actor
+ */
+uint8_t actor_get_pending(uint8_t actor_id)
+{
+    actor_t* actor = actor_get(actor_id);
+
+    if (actor == NULL) {
+        return 0;
+    }
+    return actor->count;
+}
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Look up a created actor
+ */
+static actor_t* actor_get(uint8_t actor_id)
+{
+    if (actor_id >= ACTOR_MAX_COUNT || actors[actor_id].handler == NULL) {
+        return NULL;
+    }
+    return &actors[actor_id];
+}
+
+/**
+ * @brief Pick the next ready actor of a priority level, round-robin
+ * @note Caller must hold the critical section and actor_ready[priority]
+ *       must not be empty
+ */
+static uint8_t actor_next_ready(uint8_t priority)
+{
+    uint32_t mask = actor_ready[priority];
+    /* Actors after the last one dispatched first (2UL << 31 wraps to 0) */
+    uint32_t after = mask & ~((2UL << actor_last[priority]) - 1UL);
+    uint8_t actor_id = (uint8_t)__builtin_ctz(after != 0 ? after : mask);
+
+    actor_last[priority] = actor_id;
+    return actor_id;
+}
+
+/**
+ * @brief Dispatcher task - one event per call
+ * @note Takes the oldest event of the highest-priority ready actor and calls
+ *       its handler directly. The scheduler calls the dispatcher again until
+ *       its slice ends, so other tasks keep their share of the CPU. With no
+ *       events queued the dispatcher blocks until actor_post() wakes it.
+ */
+static void actor_dispatcher(void)
+{
+    rtos_result_t result;
+
+    ENTER_CRITICAL();
+
+    task_wait_complete(&actor_wait, &result);
+
+    if (actor_ready_prios == 0) {
+        task_block_current(&actor_wait, &actor_wait, RTOS_WAIT_FOREVER);
+        EXIT_CRITICAL();
+        return;
+    }
+
+    uint8_t priority = (uint8_t)(31 - __builtin_clz(actor_ready_prios));
+    uint8_t actor_id = actor_next_ready(priority);
+    actor_t* actor = &actors[actor_id];
+
+    /* Copy out so the handler may post to its own queue */
+    actor_event_t event = actor->queue[actor->head];
+    actor->head = (uint8_t)((actor->head + 1U) % ACTOR_QUEUE_SIZE);
+    actor->count--;
+    if (actor->count == 0) {
+        actor_ready[priority] &= ~(1UL << actor_id);
+        if (actor_ready[priority] == 0) {
+            actor_ready_prios &= ~(1UL << priority);
+        }
+    }
+
+    EXIT_CRITICAL();
+
+    actor->handler(actor_id, &event);
+}
@@ -1 +1,50 @@
-// no need
\ No newline at end of file
+#include "arm_cortex_m.h"
+
+// Run fn on its own stack: thread mode switches to PSP for the call and back
+// to MSP afterwards. Exceptions still use MSP, so the task stack only has to
+// hold the task's frames plus one exception entry frame.
+#if RTOS_PORT_HOST
+// host builds: no banked stack pointer, call on the current stack
+void cpu_run_on_stack(void (*fn)(void), uint32_t* stack_top)
+{
+    (void)stack_top;
+    fn();
+}
+#elif defined(__ARMCC_VERSION) || (defined(__GNUC__) && defined(__arm__))
+// armclang and arm-none-eabi-gcc take the same naked basic asm
+__attribute__((naked)) void cpu_run_on_stack(void (*fn)(void), uint32_t* stack_top)
+{
+    __asm volatile(
+        "push   {r4, lr}        \n"
+        "msr    psp, r1         \n"
+        "mrs    r4, control     \n"
+        "orr    r2, r4, #2      \n"
+        "msr    control, r2     \n"
+        "isb                    \n"
+        "blx    r0              \n"
+        "msr    control, r4     \n"
+        "isb                    \n"
+        "pop    {r4, pc}        \n"
+    );
+}
+#else
+// Falling back to a plain call would run every task on MSP and leave the
+// stack guard with nothing to protect
+#error "cpu_run_on_stack: no PSP switch for this compiler (set RTOS_PORT_HOST=1 for host builds)"
+#endif
+
+// Busy-waits on the stimulus FIFO, so only for diagnostics output
+void cpu_itm_write_line(const char* line)
+{
+    if ((ITM_TCR_REG & ITM_TCR_ITMENA) == 0U || (ITM_TER_REG & 1U) == 0U) {
+        return;
+    }
+    for (;; line++) {
+        char c = (*line != '\0') ? *line : '\n';
+        while (ITM_PORT0_REG == 0U);            /* FIFO full */
+        *(volatile uint8_t*)&ITM_PORT0_REG = (uint8_t)c;
+        if (*line == '\0') {
+            break;
+        }
+    }
+}
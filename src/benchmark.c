@@ -0,0 +1,606 @@
+#include "benchmark.h"
+
+#if RTOS_BENCHMARK
+
+#include <stdio.h>
+#include "task_manager.h"
+#include "scheduler.h"
+#include "timer_manager.h"
+#include "memory_manager.h"
+#include "semaphore_manager.h"
+#include "queue_manager.h"
+#include "arm_cortex_m.h"
+#if RTOS_PORT_HOST
+#include <signal.h>
+#endif
+
+#define BENCH_RING_TASKS    (MAX_TASKS - 1)             /* IDLE keeps one slot */
+#define BENCH_SEM_ID        (SEMAPHORE_MAX_COUNT - 1)
+#define BENCH_QUEUE_ID      (QUEUE_MAX_COUNT - 1)
+#define BENCH_HEAP_BLOCKS   32
+#define BENCH_STEP_LIMIT    8                           /* scheduler steps per sample and task */
+
+#if RTOS_PORT_HOST
+#define BENCH_PLATFORM      "host"
+#else
+#define BENCH_PLATFORM      "cortex-m3"
+#endif
+
+#if RTOS_SCHED_POLICY == SCHED_POLICY_FIXED_PRIORITY
+#define BENCH_POLICY        "fixed_priority"
+#elif RTOS_SCHED_POLICY == SCHED_POLICY_PRIORITY_RR
+#define BENCH_POLICY        "priority_rr"
+#else
+#define BENCH_POLICY        "rr"
+#endif
+
+/* ============================================================================
+ * PRIVATE DATA STRUCTURES
+ * ============================================================================ */
+static uint32_t bench_stacks[BENCH_RING_TASKS][MIN_STACK_SIZE / sizeof(uint32_t)];
+static task_id_t bench_tasks[BENCH_RING_TASKS];
+static uint16_t bench_task_count = 0;
+
+/* Result the benchmark tasks sample into, NULL between runs */
+static bench_result_t* bench_current = NULL;
+/* Cycles one time_now_cycles() call adds to a sample */
+static uint32_t bench_overhead = 0;
+
+/* Hand-over stamp: the task that took it and when. Only the next task in
+ * the ring samples it, so laps through the suspended IDLE slot are not
+ * counted. */
+static volatile task_id_t bench_stamp_task = TASK_ID_INVALID;
+static volatile uint64_t bench_stamp = 0;
+
+static volatile uint64_t bench_isr_entry = 0;
+static volatile bool bench_isr_give = false;    /* handler also gives BENCH_SEM_ID */
+static volatile uint32_t bench_dispatched = 0;  /* calls of bench_yield_task() */
+
+#if RTOS_USE_HEAP
+static void* bench_blocks[BENCH_HEAP_BLOCKS];
+static uint32_t bench_seed = 1;
+#endif
+
+/* ============================================================================
+ * PRIVATE FUNCTION PROTOTYPES
+ * ============================================================================ */
+static void bench_begin(bench_result_t* result, const char* name, uint16_t tasks);
+static void bench_sample(bench_result_t* result, uint64_t cycles);
+static void bench_calibrate(void);
+#if RTOS_USE_HEAP
+static uint32_t bench_rand(void);
+#endif
+static void bench_stamp_now(void);
+static void bench_handover(void);
+static void bench_isr(void);
+static void bench_trigger_interrupt(void);
+#if RTOS_PORT_HOST
+static void bench_signal(int sig);
+#endif
+static bool bench_ring(bench_result_t* result, const char* name, uint16_t tasks,
+                       void (*first)(void), void (*rest)(void));
+static void bench_teardown(void);
+static void bench_dispatch(bench_result_t* result);
+static void bench_yield_task(void);
+static void bench_switch_task(void);
+static void bench_giver_task(void);
+static void bench_interrupted_task(void);
+static void bench_taker_task(void);
+static void bench_sender_task(void);
+static void bench_receiver_task(void);
+static void bench_interrupt_latency(bench_result_t* result);
+#if RTOS_USE_HEAP
+static void bench_memory(bench_result_t* alloc_result, bench_result_t* free_result,
+                         bench_result_t* deferred_result);
+#endif
+static void bench_task_churn(bench_result_t* result);
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Run all benchmarks
+ */
+uint16_t bench_run_all(bench_result_t* results, uint16_t max_results)
+{
+    bench_result_t all[BENCH_MAX_RESULTS];
+    uint16_t count = 0;
+    task_id_t idle = task_find_by_name("IDLE");
+
+    scheduler_start();
+
+    /* Without DWT the target timebase only advances inside slices */
+    uint64_t start = time_now_cycles();
+    for (volatile int i = 0; i < 1000; i++);
+    if (time_now_cycles() == start) {
+        return 0;
+    }
+    bench_calibrate();
+
+#if RTOS_PORT_HOST
+    signal(SIGUSR1, bench_signal);
+#endif
+    semaphore_create_binary(BENCH_SEM_ID, false);
+    queue_create(BENCH_QUEUE_ID, sizeof(uint32_t));
+
+    /* IDLE would take a whole slice per lap */
+    task_set_state(idle, TASK_STATE_SUSPENDED);
+
+    bench_ring(&all[count++], "task_switch", 2, bench_switch_task, bench_switch_task);
+    bench_ring(&all[count++], "task_switch_ring", BENCH_RING_TASKS,
+               bench_switch_task, bench_switch_task);
+    bench_dispatch(&all[count++]);
+    bench_ring(&all[count++], "preemption", 2, bench_interrupted_task, bench_taker_task);
+    bench_ring(&all[count++], "semaphore_shuffle", 2, bench_giver_task, bench_taker_task);
+    bench_ring(&all[count++], "message_latency", 2, bench_sender_task, bench_receiver_task);
+    bench_interrupt_latency(&all[count++]);
+#if RTOS_USE_HEAP
+    bench_memory(&all[count], &all[count + 1], &all[count + 2]);
+    count += 3;
+#endif
+    bench_task_churn(&all[count++]);
+
+    task_set_state(idle, TASK_STATE_READY);
+#if RTOS_PORT_HOST
+    signal(SIGUSR1, SIG_DFL);
+#endif
+
+    if (count > max_results) {
+        count = max_results;
+    }
+    memcpy(results, all, count * sizeof(bench_result_t));
+    return count;
+}
+
+/**
+ * @brief Write results as CSV, header line first
+ */
+void bench_write_csv(const bench_result_t* results, uint16_t count, bench_write_t write)
+{
+    char line[96];
+
+    snprintf(line, sizeof(line), "# platform=%s clock_hz=%lu policy=%s",
+             BENCH_PLATFORM, (unsigned long)SYSTEM_CLOCK_HZ, BENCH_POLICY);
+    write(line);
+    write("benchmark,tasks,iterations,min_cycles,avg_cycles,max_cycles,avg_ns");
+
+    for (uint16_t i = 0; i < count; i++) {
+        const bench_result_t* r = &results[i];
+        uint32_t avg = 0;
+        uint32_t avg_ns = 0;
+
+        if (r->iterations != 0) {
+            /* Mean in milli-cycles first, so sub-cycle means survive */
+            uint64_t avg_mc = r->total_cycles * 1000U / r->iterations;
+            avg = (uint32_t)(avg_mc / 1000U);
+            avg_ns = (uint32_t)(avg_mc * 1000000U / SYSTEM_CLOCK_HZ);
+        }
+        snprintf(line, sizeof(line), "%s,%u,%lu,%lu,%lu,%lu,%lu",
+                 r->name, (unsigned)r->tasks, (unsigned long)r->iterations,
+                 (unsigned long)(r->iterations ? r->min_cycles : 0),
+                 (unsigned long)avg, (unsigned long)r->max_cycles,
+                 (unsigned long)avg_ns);
+        write(line);
+    }
+}
+
+#if !RTOS_PORT_HOST
+/* Interrupt used by the interrupt_latency and preemption runs */
+void PendSV_Handler(void)
+{
+    bench_isr();
+}
+#endif
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Reset a result before a run
+ */
+static void bench_begin(bench_result_t* result, const char* name, uint16_t tasks)
+{
+    result->name = name;
+    result->tasks = tasks;
+    result->iterations = 0;
+    result->min_cycles = 0xFFFFFFFFU;
+    result->max_cycles = 0;
+    result->total_cycles = 0;
+}
+
+/**
+ * @brief Add one sample, minus the clock read it contains
+ */
+static void bench_sample(bench_result_t* result, uint64_t cycles)
+{
+    uint32_t c = (cycles > bench_overhead) ? (uint32_t)(cycles - bench_overhead) : 0U;
+
+    if (c < result->min_cycles) {
+        result->min_cycles = c;
+    }
+    if (c > result->max_cycles) {
+        result->max_cycles = c;
+    }
+    result->total_cycles += c;
+    result->iterations++;
+}
+
+/**
+ * @brief Measure the cost of reading the clock (best of a few reads)
+ */
+static void bench_calibrate(void)
+{
+    uint64_t best = 0xFFFFFFFFU;
+
+    for (int i = 0; i < 64; i++) {
+        uint64_t t0 = time_now_cycles();
+        uint64_t t1 = time_now_cycles();
+        if (t1 - t0 < best) {
+            best = t1 - t0;
+        }
+    }
+    bench_overhead = (uint32_t)best;
+}
+
+#if RTOS_USE_HEAP
+/**
+ * @brief Pseudo-random numbers for block sizes (LCG, fixed seed per run)
+ */
+static uint32_t bench_rand(void)
+{
+    bench_seed = bench_seed * 1664525U + 1013904223U;
+    return bench_seed >> 16;
+}
+#endif
+
+/**
+ * @brief Record that the current task hands over now
+ */
+static void bench_stamp_now(void)
+{
+    bench_stamp_task = task_get_current()->task_id;
+    bench_stamp = time_now_cycles();
+}
+
+/**
+ * @brief Sample the time since the hand-over stamp, if the task before the
+ *        current one in the ring took it
+ */
+static void bench_handover(void)
+{
+    uint64_t now = time_now_cycles();
+    tcb_t* self = task_get_current();
+
+    if (bench_current != NULL && self->prev != NULL &&
+        bench_stamp_task == self->prev->task_id) {
+        bench_sample(bench_current, now - bench_stamp);
+    }
+    bench_stamp_task = TASK_ID_INVALID;
+}
+
+/**
+ * @brief Interrupt body - PendSV on the target, SIGUSR1 on the host
+ */
+static void bench_isr(void)
+{
+    uint64_t now = time_now_cycles();
+
+    bench_isr_entry = now;
+    if (bench_isr_give) {
+        /* Stamped for the interrupted task, so its successor samples it */
+        bench_stamp_task = task_get_current()->task_id;
+        bench_stamp = now;
+        semaphore_give(BENCH_SEM_ID);
+    }
+}
+
+#if RTOS_PORT_HOST
+/**
+ * @brief Host stand-in for the interrupt (raise() delivers synchronously)
+ */
+static void bench_signal(int sig)
+{
+    (void)sig;
+    bench_isr();
+}
+#endif
+
+/**
+ * @brief Raise the benchmark interrupt and return once its handler ran
+ */
+static void bench_trigger_interrupt(void)
+{
+#if RTOS_PORT_HOST
+    raise(SIGUSR1);
+#else
+    NVIC_INT_CTRL_REG = NVIC_PENDSVSET;
+    __asm volatile("dsb\n isb" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Run a ring of benchmark tasks until enough hand-overs were sampled
+ * @return bool false if the ring stalled (result has 0 iterations)
+ */
+static bool bench_ring(bench_result_t* result, const char* name, uint16_t tasks,
+                       void (*first)(void), void (*rest)(void))
+{
+    bench_begin(result, name, tasks);
+    bench_task_count = 0;
+    bench_stamp_task = TASK_ID_INVALID;
+
+    for (uint16_t i = 0; i < tasks; i++) {
+        task_id_t id = task_create_static((i == 0) ? first : rest, "Bench",
+                                          bench_stacks[i], sizeof(bench_stacks[i]));
+        if (id == TASK_ID_INVALID) {
+            bench_teardown();
+            return false;
+        }
+        bench_tasks[bench_task_count++] = id;
+    }
+
+    /* Warm-up laps, then the measured run */
+    uint32_t samples = BENCH_WARMUP;
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t steps = samples * BENCH_STEP_LIMIT * (tasks + 1U);
+
+        bench_begin(result, name, tasks);
+        bench_current = result;
+        while (result->iterations < samples && steps-- != 0U) {
+            scheduler_step();
+        }
+        bench_current = NULL;
+        if (result->iterations < samples) {
+            result->iterations = 0;
+            break;
+        }
+        samples = BENCH_ITERATIONS;
+    }
+
+    bench_teardown();
+    return result->iterations != 0;
+}
+
+/**
+ * @brief Delete the benchmark tasks and reclaim their slots
+ */
+static void bench_teardown(void)
+{
+    while (bench_task_count != 0) {
+        task_delete(bench_tasks[--bench_task_count]);
+    }
+    task_reap_deleted();
+    /* Drop a token or message a run left behind */
+    while (semaphore_take(BENCH_SEM_ID, 0) == RTOS_SUCCESS);
+    uint32_t item;
+    while (queue_receive(BENCH_QUEUE_ID, &item) == QUEUE_OK);
+}
+
+/**
+ * @brief Time scheduler_step() from outside, over a full ring of tasks
+ * @note Only steps that dispatched a task are sampled - in round-robin
+ *       the suspended IDLE slot takes a step of its own
+ */
+static void bench_dispatch(bench_result_t* result)
+{
+    bench_begin(result, "scheduler_step", BENCH_RING_TASKS);
+    bench_task_count = 0;
+
+    for (uint16_t i = 0; i < BENCH_RING_TASKS; i++) {
+        task_id_t id = task_create_static(bench_yield_task, "Bench",
+                                          bench_stacks[i], sizeof(bench_stacks[i]));
+        if (id == TASK_ID_INVALID) {
+            bench_teardown();
+            result->iterations = 0;
+            return;
+        }
+        bench_tasks[bench_task_count++] = id;
+    }
+
+    uint32_t steps = (BENCH_WARMUP + BENCH_ITERATIONS) * BENCH_STEP_LIMIT;
+    while (result->iterations < BENCH_ITERATIONS && steps-- != 0U) {
+        uint32_t dispatched = bench_dispatched;
+        uint64_t t0 = time_now_cycles();
+        scheduler_step();
+        uint64_t t1 = time_now_cycles();
+
+        /* Steps that passed a slot over, and the warm-up, are not sampled */
+        if (bench_dispatched != dispatched && bench_dispatched > BENCH_WARMUP) {
+            bench_sample(result, t1 - t0);
+        }
+    }
+
+    bench_teardown();
+    bench_dispatched = 0;
+}
+
+/**
+ * @brief Count the call and give up the slice
+ */
+static void bench_yield_task(void)
+{
+    bench_dispatched++;
+    scheduler_yield();
+}
+
+/**
+ * @brief Yield on every call - each call is one hand-over
+ */
+static void bench_switch_task(void)
+{
+    bench_handover();
+    scheduler_yield();
+    bench_stamp_now();
+}
+
+/**
+ * @brief Give the semaphore the next task waits on, then yield
+ */
+static void bench_giver_task(void)
+{
+    scheduler_yield();
+    bench_stamp_now();
+    semaphore_give(BENCH_SEM_ID);
+}
+
+/**
+ * @brief Let an interrupt give the semaphore, then yield at once
+ */
+static void bench_interrupted_task(void)
+{
+    scheduler_yield();
+    bench_isr_give = true;
+    bench_trigger_interrupt();
+    bench_isr_give = false;
+}
+
+/**
+ * @brief Wait on the semaphore and sample when it arrives
+ * @note After a successful take the next call blocks again, which ends
+ *       the slice
+ */
+static void bench_taker_task(void)
+{
+    if (semaphore_take(BENCH_SEM_ID, RTOS_WAIT_FOREVER) == RTOS_SUCCESS) {
+        bench_handover();
+    }
+}
+
+/**
+ * @brief Send one message per call, then yield
+ */
+static void bench_sender_task(void)
+{
+    static uint32_t sequence = 0;
+
+    scheduler_yield();
+    sequence++;
+    bench_stamp_now();
+    queue_send(BENCH_QUEUE_ID, &sequence);
+}
+
+/**
+ * @brief Poll the queue once per call and sample each message
+ */
+static void bench_receiver_task(void)
+{
+    uint32_t sequence;
+
+    scheduler_yield();
+    if (queue_receive(BENCH_QUEUE_ID, &sequence) == QUEUE_OK) {
+        bench_handover();
+    }
+}
+
+/**
+ * @brief Time from pending the interrupt to the first line of its handler
+ */
+static void bench_interrupt_latency(bench_result_t* result)
+{
+    bench_begin(result, "interrupt_latency", 0);
+    bench_isr_give = false;
+
+    for (uint32_t i = 0; i < BENCH_WARMUP + BENCH_ITERATIONS; i++) {
+        if (i == BENCH_WARMUP) {
+            bench_begin(result, "interrupt_latency", 0);
+        }
+        uint64_t t0 = time_now_cycles();
+        bench_trigger_interrupt();
+        bench_sample(result, bench_isr_entry - t0);
+    }
+}
+
+#if RTOS_USE_HEAP
+/**
+ * @brief memory_alloc()/memory_free() on a fragmented heap
+ * @note Fills the heap with blocks of mixed size, frees every other one,
+ *       then times alloc/free pairs of random size that have to search the
+ *       holes, and the same frees through memory_free_from_isr() (merged
+ *       by the next, untimed, alloc). Everything is freed again at the end.
+ */
+static void bench_memory(bench_result_t* alloc_result, bench_result_t* free_result,
+                         bench_result_t* deferred_result)
+{
+    uint16_t blocks = 0;
+
+    bench_seed = 1;
+    while (blocks < BENCH_HEAP_BLOCKS) {
+        bench_blocks[blocks] = memory_alloc(16U + (bench_rand() % 64U));
+        if (bench_blocks[blocks] == NULL) {
+            break;
+        }
+        blocks++;
+    }
+    for (uint16_t i = 1; i < blocks; i += 2) {
+        memory_free(bench_blocks[i]);
+        bench_blocks[i] = NULL;
+    }
+
+    bench_begin(alloc_result, "memory_alloc", 0);
+    bench_begin(free_result, "memory_free", 0);
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        uint32_t size = 8U + (bench_rand() % 96U);
+
+        uint64_t t0 = time_now_cycles();
+        void* ptr = memory_alloc(size);
+        uint64_t t1 = time_now_cycles();
+        if (ptr == NULL) {
+            continue;
+        }
+        bench_sample(alloc_result, t1 - t0);
+
+        t0 = time_now_cycles();
+        memory_free(ptr);
+        t1 = time_now_cycles();
+        bench_sample(free_result, t1 - t0);
+    }
+
+    bench_begin(deferred_result, "memory_free_from_isr", 0);
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        void* ptr = memory_alloc(8U + (bench_rand() % 96U));
+        if (ptr == NULL) {
+            continue;
+        }
+        uint64_t t0 = time_now_cycles();
+        memory_free_from_isr(ptr);
+        bench_sample(deferred_result, time_now_cycles() - t0);
+    }
+    memory_reclaim_deferred();
+
+    for (uint16_t i = 0; i < blocks; i += 2) {
+        memory_free(bench_blocks[i]);
+    }
+}
+#endif
+
+/**
+ * @brief Create, delete and reap a task (the churn path)
+ */
+static void bench_task_churn(bench_result_t* result)
+{
+    bench_begin(result, "task_churn", 0);
+
+    for (uint32_t i = 0; i < BENCH_WARMUP + BENCH_ITERATIONS; i++) {
+        if (i == BENCH_WARMUP) {
+            bench_begin(result, "task_churn", 0);
+        }
+        uint64_t t0 = time_now_cycles();
+#if RTOS_USE_HEAP
+        task_id_t id = task_create(bench_switch_task, "Churn", MIN_STACK_SIZE);
+#else
+        task_id_t id = task_create_static(bench_switch_task, "Churn",
+                                          bench_stacks[0], sizeof(bench_stacks[0]));
+#endif
+        if (id == TASK_ID_INVALID) {
+            result->iterations = 0;
+            return;
+        }
+        task_delete(id);
+        task_reap_deleted();
+        bench_sample(result, time_now_cycles() - t0);
+    }
+}
+
+#endif /* RTOS_BENCHMARK */
@@ -0,0 +1,47 @@
+#include "coroutine.h"
+#include "arm_cortex_m.h"
+
+/* ============================================================================
+ * PRIVATE DATA STRUCTURES
+ * ============================================================================ */
+
+/* Coroutines in CO_DELAY - only ever woken by their timeout */
+static task_wait_list_t coroutine_sleepers;
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create a coroutine task
+ */
+task_id_t coroutine_create(void (*task_function)(void), const char* task_name)
+{
+    return task_create_stackless(task_function, task_name);
+}
+
+/**
+ * @brief Block the current task for a number of ticks
+ * @note A delay of 0 only gives up the rest of the slice
+ */
+void coroutine_delay(uint32_t ticks)
+{
+    if (ticks == 0) {
+        scheduler_yield();
+        return;
+    }
+
+    ENTER_CRITICAL();
+    task_block_current(&coroutine_sleepers, &coroutine_sleepers, ticks);
+    EXIT_CRITICAL();
+}
+
+/**
+ * @brief Clear the finished delay of the current task
+ */
+void coroutine_delay_done(void)
+{
+    ENTER_CRITICAL();
+    task_wait_complete(&coroutine_sleepers, NULL);
+    EXIT_CRITICAL();
+}
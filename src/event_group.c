@@ -0,0 +1,257 @@
+#include "event_group.h"
+#include "task_manager.h"
+#include "arm_cortex_m.h"
+
+/* ============================================================================
+ * PRIVATE DATA STRUCTURES
+ * ============================================================================ */
+typedef struct {
+    uint32_t          bits;
+    task_wait_list_t  waiters;
+    bool              initialized;
+} event_group_t;
+
+static event_group_t event_groups[EVENT_GROUP_MAX_COUNT];
+
+/* ============================================================================
+ * PRIVATE FUNCTION PROTOTYPES
+ * ============================================================================ */
+static event_group_t* event_group_get(uint8_t group_id);
+static bool event_group_condition_met(uint32_t current, uint32_t bits, uint8_t options);
+static void event_group_set_bits_locked(event_group_t* group, uint32_t bits);
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize event group subsystem
+ */
+void event_group_init(void)
+{
+    for (uint8_t i = 0; i < EVENT_GROUP_MAX_COUNT; i++) {
+        event_groups[i].bits = 0;
+        task_wait_list_init(&event_groups[i].waiters);
+        event_groups[i].initialized = false;
+    }
+}
+
+/**
+ * @brief Create an event group with all flags cleared
+ */
+rtos_result_t event_group_create(uint8_t group_id)
+{
+    if (group_id >= EVENT_GROUP_MAX_COUNT) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    event_groups[group_id].bits = 0;
+    task_wait_list_init(&event_groups[group_id].waiters);
+    event_groups[group_id].initialized = true;
+
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Set flags and wake every waiter whose condition is now met
+ */
+rtos_result_t event_group_set_bits(uint8_t group_id, uint32_t bits)
+{
+    event_group_t* group = event_group_get(group_id);
+
+    if (group == NULL) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    ENTER_CRITICAL();
+    event_group_set_bits_locked(group, bits);
+    EXIT_CRITICAL();
+
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Clear flags
+ */
+rtos_result_t event_group_clear_bits(uint8_t group_id, uint32_t bits)
+{
+    event_group_t* group = event_group_get(group_id);
+
+    if (group == NULL) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    ENTER_CRITICAL();
+    group->bits &= ~bits;
+    EXIT_CRITICAL();
+
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Read the current flag word
+ */
+uint32_t event_group_get_bits(uint8_t group_id)
+{
+    event_group_t* group = event_group_get(group_id);
+
+    if (group == NULL) {
+        return 0;
+    }
+    return group->bits;
+}
+
+/**
+ * @brief Wait for any/all of the given flags
+ */
+rtos_result_t event_group_wait_bits(uint8_t group_id, uint32_t bits,
+                                    uint8_t options, uint32_t* result_bits)
+{
+    event_group_t* group = event_group_get(group_id);
+    rtos_result_t result;
+
+    if (group == NULL || bits == 0) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    ENTER_CRITICAL();
+
+    /* Woken by event_group_set_bits() since the last call */
+    if (task_wait_complete(group, &result)) {
+        if (result_bits != NULL) {
+            *result_bits = task_get_current()->wait_value;
+        }
+        EXIT_CRITICAL();
+        return result;
+    }
+
+    uint32_t current = group->bits;
+
+    if (event_group_condition_met(current, bits, options)) {
+        if (options & EVENT_CLEAR_ON_EXIT) {
+            group->bits &= ~bits;
+        }
+        EXIT_CRITICAL();
+        if (result_bits != NULL) {
+            *result_bits = current;
+        }
+        return RTOS_SUCCESS;
+    }
+
+    result = task_block_current(&group->waiters, group, RTOS_WAIT_FOREVER);
+    if (result == RTOS_BLOCKED) {
+        tcb_t* tcb = task_get_current();
+        tcb->wait_value = bits;
+        tcb->wait_options = options;
+    }
+
+    EXIT_CRITICAL();
+
+    return result;
+}
+
+/**
+ * @brief Barrier: set own flags, then wait until all wait_bits are set
+ */
+rtos_result_t event_group_sync(uint8_t group_id, uint32_t set_bits,
+                               uint32_t wait_bits, uint32_t* result_bits)
+{
+    event_group_t* group = event_group_get(group_id);
+    rtos_result_t result;
+
+    if (group == NULL || wait_bits == 0) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    ENTER_CRITICAL();
+
+    /* Released by the last party to arrive */
+    if (task_wait_complete(group, &result)) {
+        if (result_bits != NULL) {
+            *result_bits = task_get_current()->wait_value;
+        }
+        EXIT_CRITICAL();
+        return result;
+    }
+
+    /* Decide before setting: waking the other parties clears the bits */
+    bool last_to_arrive = ((group->bits | set_bits) & wait_bits) == wait_bits;
+
+    event_group_set_bits_locked(group, set_bits);
+
+    if (last_to_arrive) {
+        uint32_t current = group->bits | wait_bits;
+        group->bits &= ~wait_bits;
+        EXIT_CRITICAL();
+        if (result_bits != NULL) {
+            *result_bits = current;
+        }
+        return RTOS_SUCCESS;
+    }
+
+    result = task_block_current(&group->waiters, group, RTOS_WAIT_FOREVER);
+    if (result == RTOS_BLOCKED) {
+        tcb_t* tcb = task_get_current();
+        tcb->wait_value = wait_bits;
+        tcb->wait_options = EVENT_WAIT_ALL | EVENT_CLEAR_ON_EXIT;
+    }
+
+    EXIT_CRITICAL();
+
+    return result;
+}
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Look up an initialized event group
+ */
+static event_group_t* event_group_get(uint8_t group_id)
+{
+    if (group_id >= EVENT_GROUP_MAX_COUNT || !event_groups[group_id].initialized) {
+        return NULL;
+    }
+    return &event_groups[group_id];
+}
+
+/**
+ * @brief Evaluate a wait-any / wait-all condition
+ */
+static bool event_group_condition_met(uint32_t current, uint32_t bits, uint8_t options)
+{
+    if (options & EVENT_WAIT_ALL) {
+        return (current & bits) == bits;
+    }
+    return (current & bits) != 0;
+}
+
+/**
+ * @brief Set flags and wake satisfied waiters in a single pass
+ * @note Caller must hold the critical section. Clear-on-exit bits are
+ *       collected during the pass and cleared at the end, so every waiter
+ *       sees the same flag word.
+ */
+static void event_group_set_bits_locked(event_group_t* group, uint32_t bits)
+{
+    uint32_t clear_bits = 0;
+    tcb_t* tcb = group->waiters.head;
+
+    group->bits |= bits;
+
+    while (tcb != NULL) {
+        tcb_t* next = tcb->wait_next;
+
+        if (event_group_condition_met(group->bits, tcb->wait_value, tcb->wait_options)) {
+            if (tcb->wait_options & EVENT_CLEAR_ON_EXIT) {
+                clear_bits |= tcb->wait_value;
+            }
+            tcb->wait_value = group->bits;
+            task_wake(tcb, RTOS_SUCCESS);
+        }
+        tcb = next;
+    }
+
+    group->bits &= ~clear_bits;
+}
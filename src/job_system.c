@@ -0,0 +1,507 @@
+#include "job_system.h"
+#include "task_manager.h"
+#include "arm_cortex_m.h"
+
+#define JOB_THREADS         (RTOS_PORT_HOST && JOB_HOST_THREADS)
+
+#if JOB_THREADS
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if (JOB_DEQUE_SIZE & (JOB_DEQUE_SIZE - 1)) != 0
+#error "JOB_DEQUE_SIZE must be a power of two"
+#endif
+
+#define JOB_DEQUE_MASK      (JOB_DEQUE_SIZE - 1U)
+#define JOB_EXTERNAL        JOB_WORKERS                 /* deque of tasks outside the pool */
+#define JOB_DEQUES          (JOB_WORKERS + 1)
+#define JOB_IDLE_SPINS      64U                         /* empty polls before a thread sleeps */
+
+/* ============================================================================
+ * PRIVATE DATA STRUCTURES
+ * ============================================================================ */
+
+/* Chase-Lev deque. The owner pushes and pops at bottom, thieves take from
+ * top. Both indexes run freely; they are compared by signed difference, so
+ * wrapping at 2^32 is harmless. */
+typedef struct {
+    volatile uint32_t top;
+    volatile uint32_t bottom;
+    job_t* volatile slots[JOB_DEQUE_SIZE];
+} job_deque_t;
+
+static job_deque_t job_deques[JOB_DEQUES];
+
+#if JOB_THREADS
+static pthread_t job_threads[JOB_WORKERS];
+static volatile bool job_stopping = false;
+static __thread uint16_t job_thread_index = JOB_EXTERNAL;
+
+/* Threads outside the pool share the external deque, which takes one
+ * owner at a time - this serializes their pushes and pops */
+static volatile bool job_external_lock = false;
+
+/* Idle workers sleep on job_wake; job_sleepers lets a submit skip the
+ * mutex while every worker is awake */
+static pthread_mutex_t job_wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_wake = PTHREAD_COND_INITIALIZER;
+static volatile uint32_t job_sleepers = 0;
+#else
+static uint32_t job_worker_stacks[JOB_WORKERS][JOB_WORKER_STACK_SIZE / sizeof(uint32_t)];
+static task_id_t job_worker_tasks[JOB_WORKERS];
+
+/* Workers with empty deques block here until a submit wakes one */
+static task_wait_list_t job_idle_wait;
+#endif
+static bool job_started = false;
+
+/* ============================================================================
+ * PRIVATE FUNCTION PROTOTYPES
+ * ============================================================================ */
+static bool job_deque_push(job_deque_t* deque, job_t* job);
+static job_t* job_deque_pop(job_deque_t* deque);
+static job_t* job_deque_steal(job_deque_t* deque);
+static uint16_t job_self(void);
+static job_t* job_find(uint16_t self);
+static void job_run(job_t* job);
+static void job_range_run(void* arg);
+static void job_wake_worker(void);
+#if JOB_THREADS
+static void job_external_acquire(uint16_t self);
+static void job_external_release(uint16_t self);
+static bool job_any_queued(void);
+static void* job_worker_thread(void* arg);
+#else
+static void job_worker_task(void);
+#endif
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create the worker tasks (or threads)
+ */
+rtos_result_t job_system_init(void)
+{
+    if (job_started) {
+        return RTOS_SUCCESS;
+    }
+    memset(job_deques, 0, sizeof(job_deques));
+
+#if JOB_THREADS
+    job_stopping = false;
+    for (uint16_t i = 0; i < JOB_WORKERS; i++) {
+        if (pthread_create(&job_threads[i], NULL, job_worker_thread,
+                           (void*)(uintptr_t)i) != 0) {
+            return RTOS_NO_MEMORY;
+        }
+    }
+#else
+    task_wait_list_init(&job_idle_wait);
+    for (uint16_t i = 0; i < JOB_WORKERS; i++) {
+        job_worker_tasks[i] = task_create_static(job_worker_task, "Jobs",
+                                                 job_worker_stacks[i],
+                                                 sizeof(job_worker_stacks[i]));
+        if (job_worker_tasks[i] == TASK_ID_INVALID) {
+            return RTOS_NO_MEMORY;
+        }
+    }
+#endif
+    job_started = true;
+    return RTOS_SUCCESS;
+}
+
+#if JOB_THREADS
+/**
+ * @brief Stop and join the worker threads once their deques are empty
+ */
+void job_system_shutdown(void)
+{
+    if (!job_started) {
+        return;
+    }
+    __atomic_store_n(&job_stopping, true, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&job_wake_mutex);
+    pthread_cond_broadcast(&job_wake);
+    pthread_mutex_unlock(&job_wake_mutex);
+    for (uint16_t i = 0; i < JOB_WORKERS; i++) {
+        pthread_join(job_threads[i], NULL);
+    }
+    job_started = false;
+}
+#endif
+
+/**
+ * @brief Set up an empty wait group
+ */
+void job_wait_group_init(job_wait_group_t* group)
+{
+    group->pending = 0;
+}
+
+/**
+ * @brief Whether every job of the group has finished
+ */
+bool job_wait_group_done(const job_wait_group_t* group)
+{
+    return __atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) == 0U;
+}
+
+/**
+ * @brief Queue a job
+ */
+void job_submit(job_t* job, job_fn_t fn, void* arg, job_wait_group_t* group)
+{
+    job->fn = fn;
+    job->arg = arg;
+    job->group = group;
+    if (group != NULL) {
+        __atomic_add_fetch(&group->pending, 1U, __ATOMIC_RELAXED);
+    }
+
+    uint16_t self = job_self();
+#if JOB_THREADS
+    job_external_acquire(self);
+#endif
+    bool queued = job_deque_push(&job_deques[self], job);
+#if JOB_THREADS
+    job_external_release(self);
+#endif
+
+    if (!queued) {
+        /* Deque full - running it now also throttles the producer */
+        job_run(job);
+        return;
+    }
+    job_wake_worker();
+}
+
+/**
+ * @brief Run fn over [begin, end) in chunks of grain indexes
+ */
+void job_parallel_for(job_range_t* range, uint32_t begin, uint32_t end, uint32_t grain,
+                      job_range_fn_t fn, void* arg, job_wait_group_t* group)
+{
+    if (begin >= end) {
+        return;
+    }
+    if (grain == 0U) {
+        grain = 1U;
+    }
+
+    range->fn = fn;
+    range->arg = arg;
+    range->next = begin;
+    range->end = end;
+    range->grain = grain;
+
+    /* No more jobs than chunks - a spare job would only find nothing left */
+    uint32_t chunks = (end - begin) / grain + (((end - begin) % grain) != 0U);
+    uint32_t jobs = (chunks < JOB_WORKERS + 1U) ? chunks : JOB_WORKERS + 1U;
+
+    for (uint32_t i = 0; i < jobs; i++) {
+        job_submit(&range->jobs[i], job_range_run, range, group);
+    }
+}
+
+/**
+ * @brief Run queued jobs until the group is done
+ */
+bool job_wait(job_wait_group_t* group)
+{
+    uint16_t self = job_self();
+
+    while (!job_wait_group_done(group)) {
+        job_t* job = job_find(self);
+
+        if (job != NULL) {
+            job_run(job);
+            continue;
+        }
+#if JOB_THREADS
+        /* The rest is running on other threads */
+        sched_yield();
+#else
+        return false;
+#endif
+    }
+    return true;
+}
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Owner: add a job at the bottom
+ * @return bool false if the deque is full
+ */
+static bool job_deque_push(job_deque_t* deque, job_t* job)
+{
+    uint32_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    uint32_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+
+    if ((int32_t)(bottom - top) >= (int32_t)JOB_DEQUE_SIZE) {
+        return false;
+    }
+    __atomic_store_n(&deque->slots[bottom & JOB_DEQUE_MASK], job, __ATOMIC_RELAXED);
+    /* Release: the job and its slot are written before a thief can see
+     * the new bottom */
+    __atomic_store_n(&deque->bottom, bottom + 1U, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief Owner: take the newest job from the bottom
+ * @note Only the last job can be contended; a compare-and-swap on top
+ *       decides between the owner and a thief
+ */
+static job_t* job_deque_pop(job_deque_t* deque)
+{
+    uint32_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1U;
+
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint32_t top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+    if ((int32_t)(bottom - top) < 0) {
+        /* Empty */
+        __atomic_store_n(&deque->bottom, bottom + 1U, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    job_t* job = __atomic_load_n(&deque->slots[bottom & JOB_DEQUE_MASK], __ATOMIC_RELAXED);
+    if (bottom == top) {
+        if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1U, false,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            job = NULL;     /* a thief got it */
+        }
+        __atomic_store_n(&deque->bottom, bottom + 1U, __ATOMIC_RELAXED);
+    }
+    return job;
+}
+
+/**
+ * @brief Thief: take the oldest job from the top
+ */
+static job_t* job_deque_steal(job_deque_t* deque)
+{
+    uint32_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint32_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+
+    if ((int32_t)(bottom - top) <= 0) {
+        return NULL;
+    }
+
+    job_t* job = __atomic_load_n(&deque->slots[top & JOB_DEQUE_MASK], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1U, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL;        /* lost to the owner or another thief */
+    }
+    return job;
+}
+
+/**
+ * @brief Index of the caller's deque
+ */
+static uint16_t job_self(void)
+{
+#if JOB_THREADS
+    return job_thread_index;
+#else
+    tcb_t* tcb = task_get_current();
+
+    if (tcb != NULL && job_started) {
+        for (uint16_t i = 0; i < JOB_WORKERS; i++) {
+            if (job_worker_tasks[i] == tcb->task_id) {
+                return i;
+            }
+        }
+    }
+    return JOB_EXTERNAL;
+#endif
+}
+
+/**
+ * @brief Next job for a context: its own newest, else the oldest of another
+ */
+static job_t* job_find(uint16_t self)
+{
+#if JOB_THREADS
+    job_external_acquire(self);
+#endif
+    job_t* job = job_deque_pop(&job_deques[self]);
+#if JOB_THREADS
+    job_external_release(self);
+#endif
+
+    for (uint16_t i = 1; job == NULL && i < JOB_DEQUES; i++) {
+        job = job_deque_steal(&job_deques[(self + i) % JOB_DEQUES]);
+    }
+    return job;
+}
+
+/**
+ * @brief Run a job and count it off its group
+ */
+static void job_run(job_t* job)
+{
+    /* The job may be reused as soon as its function has run */
+    job_wait_group_t* group = job->group;
+
+    job->fn(job->arg);
+    if (group != NULL) {
+        __atomic_sub_fetch(&group->pending, 1U, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief One parallel_for job - takes chunks until the range is used up
+ */
+static void job_range_run(void* arg)
+{
+    job_range_t* range = (job_range_t*)arg;
+    uint32_t begin;
+    uint32_t end;
+
+    for (;;) {
+        /* Claim the next chunk */
+        begin = __atomic_load_n(&range->next, __ATOMIC_RELAXED);
+        do {
+            if (begin >= range->end) {
+                return;
+            }
+            end = (range->end - begin > range->grain) ? begin + range->grain : range->end;
+        } while (!__atomic_compare_exchange_n(&range->next, &begin, end, true,
+                                              __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+        range->fn(begin, end, range->arg);
+    }
+}
+
+#if JOB_THREADS
+/**
+ * @brief Wake one sleeping worker thread, if any, for a job just queued
+ */
+static void job_wake_worker(void)
+{
+    /* Pairs with the fence in job_worker_thread(): either this sees the
+     * sleeper, or the sleeper sees the job */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&job_sleepers, __ATOMIC_RELAXED) != 0U) {
+        pthread_mutex_lock(&job_wake_mutex);
+        pthread_cond_signal(&job_wake);
+        pthread_mutex_unlock(&job_wake_mutex);
+    }
+}
+
+/**
+ * @brief Take the external deque's owner lock (no-op for pool threads)
+ */
+static void job_external_acquire(uint16_t self)
+{
+    if (self != JOB_EXTERNAL) {
+        return;
+    }
+    while (__atomic_exchange_n(&job_external_lock, true, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+static void job_external_release(uint16_t self)
+{
+    if (self == JOB_EXTERNAL) {
+        __atomic_store_n(&job_external_lock, false, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief Whether any deque holds a job
+ */
+static bool job_any_queued(void)
+{
+    for (uint16_t i = 0; i < JOB_DEQUES; i++) {
+        uint32_t top = __atomic_load_n(&job_deques[i].top, __ATOMIC_ACQUIRE);
+        uint32_t bottom = __atomic_load_n(&job_deques[i].bottom, __ATOMIC_ACQUIRE);
+        if ((int32_t)(bottom - top) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Host worker thread - runs jobs until job_system_shutdown()
+ * @note An idle thread polls JOB_IDLE_SPINS times, then sleeps until a
+ *       submit signals it
+ */
+static void* job_worker_thread(void* arg)
+{
+    uint32_t idle = 0;
+
+    job_thread_index = (uint16_t)(uintptr_t)arg;
+
+    for (;;) {
+        job_t* job = job_find(job_thread_index);
+
+        if (job != NULL) {
+            job_run(job);
+            idle = 0;
+        } else if (__atomic_load_n(&job_stopping, __ATOMIC_ACQUIRE)) {
+            return NULL;
+        } else if (++idle < JOB_IDLE_SPINS) {
+            sched_yield();
+        } else {
+            pthread_mutex_lock(&job_wake_mutex);
+            __atomic_add_fetch(&job_sleepers, 1U, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (!job_any_queued() && !__atomic_load_n(&job_stopping, __ATOMIC_ACQUIRE)) {
+                pthread_cond_wait(&job_wake, &job_wake_mutex);
+            }
+            __atomic_sub_fetch(&job_sleepers, 1U, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&job_wake_mutex);
+            idle = 0;
+        }
+    }
+}
+#else
+/**
+ * @brief Wake one blocked worker task, if any, for a job just queued
+ */
+static void job_wake_worker(void)
+{
+    /* Only tasks touch this list, so a busy pool costs one read */
+    if (job_idle_wait.head == NULL) {
+        return;
+    }
+    ENTER_CRITICAL();
+    task_wake(job_idle_wait.head, RTOS_SUCCESS);
+    EXIT_CRITICAL();
+}
+
+/**
+ * @brief Worker task - one job per call
+ * @note The scheduler calls it again for the rest of the slice, so queued
+ *       jobs run back to back with no task switch in between. With every
+ *       deque empty the worker blocks until job_submit() wakes it, so it
+ *       does not keep lower priorities (and the idle task) from running.
+ *       Nothing can be queued between the search and the block: other
+ *       tasks only run between calls, and ISRs do not submit.
+ */
+static void job_worker_task(void)
+{
+    rtos_result_t result;
+    job_t* job = job_find(job_self());
+
+    if (job == NULL) {
+        ENTER_CRITICAL();
+        task_wait_complete(&job_idle_wait, &result);
+        task_block_current(&job_idle_wait, &job_idle_wait, RTOS_WAIT_FOREVER);
+        EXIT_CRITICAL();
+        return;
+    }
+    job_run(job);
+}
+#endif
@@ -2,6 +2,40 @@
 #include "task_manager.h"
 #include "scheduler.h"
 #include "memory_manager.h"
+#include "timer_manager.h"
+#include "actor.h"
+#include "coroutine.h"
+#include "benchmark.h"
+#include "profiler.h"
+#include "arm_cortex_m.h"
+
+// set to 1 to add a task that creates and deletes short-lived workers
+#define DEMO_TASK_CHURN 0
+// set to 1 to add a task that refreshes the stack report once per second
+#define DEMO_STACK_REPORT 0
+// set to 1 to run a periodic software timer instead of a polling task
+#define DEMO_SOFT_TIMER 0
+// set to 1 to run two ping-pong actors on the shared dispatcher stack
+#define DEMO_ACTORS 0
+// set to 1 to add a coroutine task that counts in steps with delays
+#define DEMO_COROUTINE 0
+
+#if RTOS_BENCHMARK
+// kernel benchmark results, also sent as CSV to the ITM printf viewer
+bench_result_t bench_results[BENCH_MAX_RESULTS];
+volatile uint16_t bench_result_count = 0;
+#endif
+
+#if RTOS_PROFILER
+// sends profiler samples to the ITM printf viewer - save the log and fold it
+// with tools/profiler/prof_fold.py (snprintf needs the larger stack)
+static uint32_t profiler_output_stack[512 / sizeof(uint32_t)];
+
+void profiler_output_task(void){
+    profiler_write(cpu_itm_write_line);
+    scheduler_yield();
+}
+#endif
 
 // for demo
 volatile int task1_counter = 0;
@@ -10,6 +44,12 @@ volatile int task3_counter = 0;
 volatile int scheduler_iterations = 0;
 volatile int current_task_id = 0;
 
+#if !RTOS_USE_HEAP
+static uint32_t task1_stack[DEFAULT_STACK_SIZE / sizeof(uint32_t)];
+static uint32_t task2_stack[DEFAULT_STACK_SIZE / sizeof(uint32_t)];
+static uint32_t task3_stack[DEFAULT_STACK_SIZE / sizeof(uint32_t)];
+#endif
+
 
 void task1(void){
     task1_counter++;
@@ -26,18 +66,155 @@ void task3(void){
     for (volatile int i = 0; i < 20000; i++);
 }
 
+#if DEMO_TASK_CHURN && RTOS_USE_HEAP
+// churn benchmark - watch these: heap free/largest must stay flat
+volatile uint32_t churn_created = 0;
+volatile uint32_t churn_failed = 0;
+volatile uint32_t churn_per_second = 0;
+volatile uint32_t churn_heap_free = 0;
+volatile uint32_t churn_heap_largest = 0;
+
+void churn_worker(void){
+    task_delete(task_get_current()->task_id);
+}
+
+void churn_task(void){
+    static uint32_t window_start = 0;
+    static uint32_t window_created = 0;
+
+    task_id_t id = task_create(churn_worker, "Worker", MIN_STACK_SIZE);
+    if (id == TASK_ID_INVALID) {
+        churn_failed++;
+        return;
+    }
+    // request handled - retire the worker, idle task reaps its stack
+    task_delete(id);
+    churn_created++;
+
+    uint32_t now = timer_get_tick_count();
+    if (now - window_start >= RTOS_TICK_RATE_HZ) {
+        churn_per_second = churn_created - window_created;
+        window_created = churn_created;
+        window_start = now;
+        churn_heap_free = memory_get_free_size();
+        churn_heap_largest = memory_get_largest_free_block();
+    }
+}
+#endif
+
+#if DEMO_STACK_REPORT
+// stack report - watch these after the tasks have run their deepest paths
+task_stack_report_t stack_report[MAX_TASKS];
+volatile uint16_t stack_report_count = 0;
+
+void stack_report_task(void){
+    static uint32_t last = 0;
+    uint32_t now = timer_get_tick_count();
+
+    if (now - last >= RTOS_TICK_RATE_HZ) {
+        last = now;
+        stack_report_count = task_stack_report(stack_report, MAX_TASKS);
+    }
+}
+#endif
+
+#if DEMO_SOFT_TIMER
+// incremented every 500 ticks by the timer daemon
+volatile uint32_t timer_heartbeat = 0;
+
+void heartbeat_callback(uint8_t timer_id, void* arg){
+    (void)timer_id;
+    (void)arg;
+    timer_heartbeat++;
+}
+#endif
+
+#if DEMO_ACTORS
+// each actor answers the other's event - watch actor_exchanges
+#define ACTOR_PING  0
+#define ACTOR_PONG  1
+volatile uint32_t actor_exchanges = 0;
+
+void ping_pong_handler(uint8_t actor_id, const actor_event_t* event){
+    actor_exchanges++;
+    actor_post((actor_id == ACTOR_PING) ? ACTOR_PONG : ACTOR_PING,
+               event->signal, event->param + 1);
+}
+#endif
+
+#if DEMO_COROUTINE
+// counts to 3 with a 100-tick pause between steps, then waits for task1
+volatile uint32_t coroutine_step = 0;
+
+void coroutine_task(void){
+    static int start;
+
+    CO_BEGIN();
+    for (coroutine_step = 1; coroutine_step <= 3; coroutine_step++) {
+        CO_DELAY(100);
+    }
+    start = task1_counter;
+    CO_WAIT_UNTIL(task1_counter - start >= 10);
+    CO_END();
+}
+#endif
+
 int main(void){
+#if RTOS_STATIC_TASK_TABLE
+    // task set, stacks and ready ring come from task_config.h
+    scheduler_run();
+#else
     // initialisation
+#if RTOS_USE_HEAP
     memory_init();
+#endif
     task_manager_init();
     scheduler_init();
+#if RTOS_BENCHMARK
+    // runs before any other task exists
+    bench_result_count = bench_run_all(bench_results, BENCH_MAX_RESULTS);
+    bench_write_csv(bench_results, bench_result_count, cpu_itm_write_line);
+#endif
+#if RTOS_PROFILER
+    profiler_init();
+    task_create_static(profiler_output_task, "ProfOut",
+                       profiler_output_stack, sizeof(profiler_output_stack));
+    profiler_start();
+#endif
+#if DEMO_SOFT_TIMER
+    soft_timer_init();
+    soft_timer_create(0, 500, true, heartbeat_callback, NULL);
+    soft_timer_start(0);
+#endif
+#if DEMO_COROUTINE
+    coroutine_create(coroutine_task, "Coroutine");
+#endif
+#if DEMO_ACTORS
+    actor_init();
+    actor_create(ACTOR_PING, ping_pong_handler, DEFAULT_TASK_PRIORITY);
+    actor_create(ACTOR_PONG, ping_pong_handler, DEFAULT_TASK_PRIORITY);
+    actor_post(ACTOR_PING, 0, 0);
+#endif
 
     // schedule tasks
+#if RTOS_USE_HEAP
     scheduler_add_task_fn(task1, "Task1", DEFAULT_STACK_SIZE);
     scheduler_add_task_fn(task2, "Task2", DEFAULT_STACK_SIZE);
     scheduler_add_task_fn(task3, "Task3", DEFAULT_STACK_SIZE);
+#if DEMO_TASK_CHURN
+    scheduler_add_task_fn(churn_task, "Churn", DEFAULT_STACK_SIZE);
+#endif
+#if DEMO_STACK_REPORT
+    scheduler_add_task_fn(stack_report_task, "StackRpt", DEFAULT_STACK_SIZE);
+#endif
+#else
+    task_create_static(task1, "Task1", task1_stack, sizeof(task1_stack));
+    task_create_static(task2, "Task2", task2_stack, sizeof(task2_stack));
+    task_create_static(task3, "Task3", task3_stack, sizeof(task3_stack));
+#endif
     
     scheduler_run();
+#endif
     
     return 0;
 }
@@ -2,6 +2,8 @@
 #include "rtos_config.h"
 #include "arm_cortex_m.h"
 
+#if RTOS_USE_HEAP
+
 /* ============================================================================
  * GLOBAL VARIABLES
  * ============================================================================ */
@@ -9,6 +11,13 @@ static uint8_t heap_memory[HEAP_SIZE];
 static memory_block_t* free_block_list = NULL;
 static bool is_memory_initialized = false;
 
+/* Blocks freed by memory_free_from_isr(), newest first, linked through
+ * the header's next field (unused while a block is allocated). ISRs only
+ * push; memory_merge_deferred() detaches the whole list at once inside the
+ * heap's critical section and never pops single blocks, so a push that
+ * races with it lands either on the old list or on the new empty one. */
+static memory_block_t* volatile deferred_block_list = NULL;
+
 /* ============================================================================
  * PRIVATE FUNCTION PROTOTYPES
  * ============================================================================ */
@@ -18,6 +27,7 @@ static void memory_coalesce_blocks(void);
 static void memory_insert_free_block(memory_block_t* block);
 static void memory_remove_free_block(memory_block_t* block);
 static uint32_t memory_align_size(uint32_t size);
+static uint32_t memory_merge_deferred(void);
 
 /* ============================================================================
  * PUBLIC FUNCTIONS
@@ -41,6 +51,7 @@ rtos_result_t memory_init(void)
     free_block_list->size = HEAP_SIZE;
     free_block_list->next = NULL;
     free_block_list->prev = NULL;
+    deferred_block_list = NULL;
     
     is_memory_initialized = true;
     
@@ -67,6 +78,12 @@ void* memory_alloc(uint32_t size)
     
     ENTER_CRITICAL();
     
+    /* Take back blocks freed from other contexts first */
+    if(deferred_block_list != NULL)
+    {
+        memory_merge_deferred();
+    }
+    
     /* Find suitable free block */
     memory_block_t* block = memory_find_free_block(aligned_size);
     
@@ -107,12 +124,6 @@ rtos_result_t memory_free(void* ptr)
     /* Get block header */
     memory_block_t* block = (memory_block_t*)((uint8_t*)ptr - sizeof(memory_block_t));
     
-    /* Validate block */
-    if(block->magic != MEMORY_MAGIC_USED)
-    {
-        return RTOS_ERROR;
-    }
-    
     /* Check bounds */
     if((uint8_t*)block < heap_memory || (uint8_t*)block >= heap_memory + HEAP_SIZE)
     {
@@ -121,8 +132,15 @@ rtos_result_t memory_free(void* ptr)
     
     ENTER_CRITICAL();
     
-    /* Mark block as free */
-    block->magic = MEMORY_MAGIC_FREE;
+    /* Validate and mark the block free in one step, so a concurrent
+     * memory_free_from_isr() of it cannot also claim it */
+    uint16_t magic = MEMORY_MAGIC_USED;
+    if(!__atomic_compare_exchange_n(&block->magic, &magic, (uint16_t)MEMORY_MAGIC_FREE,
+                                    false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        EXIT_CRITICAL();
+        return RTOS_ERROR;
+    }
     
     /* Add block to free list */
     memory_insert_free_block(block);
@@ -135,6 +153,105 @@ rtos_result_t memory_free(void* ptr)
     return RTOS_SUCCESS;
 }
 
+/**
+ * @brief Free a block from an ISR or from a task that does not own the heap
+ */
+rtos_result_t memory_free_from_isr(void* ptr)
+{
+    if(!is_memory_initialized || ptr == NULL)
+    {
+        return RTOS_INVALID_PARAM;
+    }
+    
+    memory_block_t* block = (memory_block_t*)((uint8_t*)ptr - sizeof(memory_block_t));
+    
+    if((uint8_t*)block < heap_memory || (uint8_t*)block >= heap_memory + HEAP_SIZE)
+    {
+        return RTOS_ERROR;
+    }
+    
+    /* Claim the block - a second free of it, from any context, fails here */
+    uint16_t magic = MEMORY_MAGIC_USED;
+    if(!__atomic_compare_exchange_n(&block->magic, &magic, (uint16_t)MEMORY_MAGIC_DEFERRED,
+                                    false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        return RTOS_ERROR;
+    }
+    
+    memory_block_t* head = __atomic_load_n(&deferred_block_list, __ATOMIC_RELAXED);
+    do
+    {
+        block->next = head;
+    } while(!__atomic_compare_exchange_n(&deferred_block_list, &head, block, true,
+                                         __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Merge blocks freed with memory_free_from_isr() back into the heap
+ */
+uint32_t memory_reclaim_deferred(void)
+{
+    uint32_t count = 0;
+    
+    if(!is_memory_initialized || deferred_block_list == NULL)
+    {
+        return 0;
+    }
+    
+    ENTER_CRITICAL();
+    count = memory_merge_deferred();
+    EXIT_CRITICAL();
+    
+    return count;
+}
+
+/**
+ * @brief Get total size of all free blocks (bytes, headers included)
+ */
+uint32_t memory_get_free_size(void)
+{
+    uint32_t total = 0;
+    
+    ENTER_CRITICAL();
+    if(deferred_block_list != NULL)
+    {
+        memory_merge_deferred();
+    }
+    for(memory_block_t* block = free_block_list; block != NULL; block = block->next)
+    {
+        total += block->size;
+    }
+    EXIT_CRITICAL();
+    
+    return total;
+}
+
+/**
+ * @brief Get size of the largest free block (bytes, header included)
+ */
+uint32_t memory_get_largest_free_block(void)
+{
+    uint32_t largest = 0;
+    
+    ENTER_CRITICAL();
+    if(deferred_block_list != NULL)
+    {
+        memory_merge_deferred();
+    }
+    for(memory_block_t* block = free_block_list; block != NULL; block = block->next)
+    {
+        if(block->size > largest)
+        {
+            largest = block->size;
+        }
+    }
+    EXIT_CRITICAL();
+    
+    return largest;
+}
+
 /* ============================================================================
  * PRIVATE FUNCTIONS
  * ============================================================================ */
@@ -228,8 +345,38 @@ static void memory_remove_free_block(memory_block_t* block)
     block->prev = NULL;
 }
 
+/**
+ * @brief Move the deferred blocks to the free list (call with interrupts
+ *        disabled)
+ * @note One coalescing pass for the whole batch, not one per block
+ */
+static uint32_t memory_merge_deferred(void)
+{
+    memory_block_t* block = __atomic_exchange_n(&deferred_block_list, NULL, __ATOMIC_ACQUIRE);
+    uint32_t count = 0;
+    
+    while(block != NULL)
+    {
+        memory_block_t* next = block->next;
+        
+        block->magic = MEMORY_MAGIC_FREE;
+        memory_insert_free_block(block);
+        count++;
+        block = next;
+    }
+    
+    if(count != 0)
+    {
+        memory_coalesce_blocks();
+    }
+    
+    return count;
+}
+
 /**
  * @brief Coalesce adjacent free blocks
+ * @note A block that absorbed its neighbour is checked again, so a run of
+ *       free blocks (several deferred frees at once) merges in one pass
  */
 static void memory_coalesce_blocks(void)
 {
@@ -238,6 +385,7 @@ static void memory_coalesce_blocks(void)
     while(current != NULL)
     {
         memory_block_t* next_addr = (memory_block_t*)((uint8_t*)current + current->size);
+        bool merged = false;
         
         /* Check if next physical block is also free */
         memory_block_t* scan = free_block_list;
@@ -248,12 +396,17 @@ static void memory_coalesce_blocks(void)
                 /* Merge blocks */
                 current->size += scan->size;
                 memory_remove_free_block(scan);
+                merged = true;
                 break;
             }
             scan = scan->next;
         }
         
-        current = current->next;
+        if(!merged)
+        {
+            current = current->next;
+        }
     }
 }
 
+#endif /* RTOS_USE_HEAP */
@@ -0,0 +1,259 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     /* REG_RIP, dl_iterate_phdr() */
+#endif
+
+#include "profiler.h"
+
+#if RTOS_PROFILER
+
+#include <stdio.h>
+#include "timer_manager.h"
+#include "arm_cortex_m.h"
+#if RTOS_PORT_HOST
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <link.h>
+#endif
+
+#if (PROFILER_BUFFER_SIZE & (PROFILER_BUFFER_SIZE - 1)) != 0 || PROFILER_BUFFER_SIZE > 32768
+#error "PROFILER_BUFFER_SIZE must be a power of two, at most 32768"
+#endif
+
+#define PROFILER_MASK       (PROFILER_BUFFER_SIZE - 1U)
+
+/* ============================================================================
+ * PRIVATE DATA STRUCTURES
+ * ============================================================================ */
+
+/* Single producer (the tick), single consumer (profiler_read). Both
+ * indexes run freely and wrap at 2^16, head - tail = samples queued. */
+static profiler_sample_t profiler_buffer[PROFILER_BUFFER_SIZE];
+static volatile uint16_t profiler_head = 0;
+static volatile uint16_t profiler_tail = 0;
+static volatile uint32_t profiler_dropped = 0;
+static volatile bool profiler_enabled = false;
+
+/* Load address of the executable - non-zero for a PIE host build */
+static uintptr_t profiler_bias = 0;
+
+/* ============================================================================
+ * PRIVATE FUNCTION PROTOTYPES
+ * ============================================================================ */
+#if RTOS_PORT_HOST
+static void profiler_signal(int sig, siginfo_t* info, void* context);
+static int profiler_find_bias(struct dl_phdr_info* info, size_t size, void* data);
+static void profiler_set_timer(uint32_t interval_us);
+#else
+void profiler_tick(uint32_t pc);
+#endif
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Empty the ring, and on the host install the SIGPROF handler
+ */
+void profiler_init(void)
+{
+    profiler_enabled = false;
+    profiler_head = 0;
+    profiler_tail = 0;
+    profiler_dropped = 0;
+
+#if RTOS_PORT_HOST
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = profiler_signal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+
+    dl_iterate_phdr(profiler_find_bias, &profiler_bias);
+#endif
+}
+
+/**
+ * @brief Start taking samples
+ */
+void profiler_start(void)
+{
+    profiler_enabled = true;
+#if RTOS_PORT_HOST
+    profiler_set_timer(1000000U / PROFILER_SAMPLE_HZ);
+#endif
+}
+
+/**
+ * @brief Stop taking samples
+ */
+void profiler_stop(void)
+{
+#if RTOS_PORT_HOST
+    profiler_set_timer(0);
+#endif
+    profiler_enabled = false;
+}
+
+/**
+ * @brief Take samples out of the ring, oldest first
+ */
+uint16_t profiler_read(profiler_sample_t* samples, uint16_t max_samples)
+{
+    uint16_t tail = profiler_tail;
+    uint16_t count = 0;
+
+    while (count < max_samples && tail != profiler_head) {
+        samples[count++] = profiler_buffer[tail & PROFILER_MASK];
+        tail++;
+    }
+    /* Frees the slots only after they were copied */
+    profiler_tail = tail;
+    return count;
+}
+
+/**
+ * @brief Samples lost because the ring was full
+ */
+uint32_t profiler_get_dropped(void)
+{
+    return profiler_dropped;
+}
+
+/**
+ * @brief Drain the ring as text
+ */
+uint16_t profiler_write(profiler_write_t write)
+{
+    profiler_sample_t chunk[16];
+    uint16_t total = 0;
+    uint16_t count;
+    char line[MAX_TASK_NAME_LENGTH + 48];
+
+    while ((count = profiler_read(chunk, 16)) != 0) {
+        if (total == 0) {
+            snprintf(line, sizeof(line), "# profiler hz=%u dropped=%lu bias=0x%lx",
+                     (unsigned)PROFILER_SAMPLE_HZ, (unsigned long)profiler_dropped,
+                     (unsigned long)profiler_bias);
+            write(line);
+        }
+        for (uint16_t i = 0; i < count; i++) {
+            task_info_t* info = task_get_info(chunk[i].task_id);
+
+            if (info != NULL) {
+                snprintf(line, sizeof(line), "%s,0x%lx",
+                         info->task_name, (unsigned long)chunk[i].pc);
+            } else {
+                snprintf(line, sizeof(line), "task%u,0x%lx",
+                         (unsigned)chunk[i].task_id, (unsigned long)chunk[i].pc);
+            }
+            write(line);
+        }
+        total += count;
+    }
+    return total;
+}
+
+/**
+ * @brief Record one sample for the current task
+ * @note Runs in the tick - a full ring drops the sample rather than wait
+ */
+void profiler_record(uintptr_t pc)
+{
+    if (!profiler_enabled) {
+        return;
+    }
+
+    uint16_t head = profiler_head;
+    if ((uint16_t)(head - profiler_tail) >= PROFILER_BUFFER_SIZE) {
+        profiler_dropped++;
+        return;
+    }
+
+    tcb_t* tcb = task_get_current();
+    profiler_sample_t* sample = &profiler_buffer[head & PROFILER_MASK];
+    sample->pc = pc;
+    sample->task_id = (tcb != NULL) ? tcb->task_id : TASK_ID_INVALID;
+    /* Publish only once the slot is filled */
+    profiler_head = (uint16_t)(head + 1U);
+}
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+#if RTOS_PORT_HOST
+/**
+ * @brief SIGPROF handler - the host's tick, PC from the signal context
+ */
+static void profiler_signal(int sig, siginfo_t* info, void* context)
+{
+    ucontext_t* uc = (ucontext_t*)context;
+
+    (void)sig;
+    (void)info;
+#if defined(__x86_64__)
+    profiler_record((uintptr_t)uc->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__aarch64__)
+    profiler_record((uintptr_t)uc->uc_mcontext.pc);
+#else
+    (void)uc;
+    profiler_record(0);
+#endif
+}
+
+/**
+ * @brief dl_iterate_phdr() callback - the first object is the executable
+ */
+static int profiler_find_bias(struct dl_phdr_info* info, size_t size, void* data)
+{
+    (void)size;
+    *(uintptr_t*)data = (uintptr_t)info->dlpi_addr;
+    return 1;
+}
+
+/**
+ * @brief Arm (or with 0, stop) the CPU-time interval timer
+ */
+static void profiler_set_timer(uint32_t interval_us)
+{
+    struct itimerval timer;
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = (suseconds_t)interval_us;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+#else
+/**
+ * @brief SysTick handler - passes the interrupted PC to profiler_tick()
+ * @note EXC_RETURN bit 2 tells which stack holds the exception frame: PSP
+ *       for task code, MSP for the scheduler loop. The stacked PC is at
+ *       offset 24. profiler_tick() returns straight from the exception.
+ */
+__attribute__((naked)) void SysTick_Handler(void)
+{
+    __asm volatile(
+        "tst    lr, #4          \n"
+        "ite    eq              \n"
+        "mrseq  r0, msp         \n"
+        "mrsne  r0, psp         \n"
+        "ldr    r0, [r0, #24]   \n"
+        "b      profiler_tick   \n"
+    );
+}
+
+/**
+ * @brief Tick body: sample, then count down the running slice
+ * @note Not static - the handler branches to it by name
+ */
+void profiler_tick(uint32_t pc)
+{
+    profiler_record(pc);
+    timer_slice_tick();
+}
+#endif
+
+#endif /* RTOS_PROFILER */
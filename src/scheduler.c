@@ -1,33 +1,53 @@
 #include "scheduler.h"
+#include "sched_policy.h"
 #include "timer_manager.h"
+#include "memory_manager.h"
+#include "arm_cortex_m.h"
 
-static tcb_t* taskList = NULL;
+static sched_queue_t readyQueue;
 static bool schedulerRunning = false;
-static uint8_t idleTaskId = 0xFF;
+static bool yieldRequested = false;
+static uint32_t sliceTicks = 0;
+static int rrIndex = 0;
+static task_id_t idleTaskId = TASK_ID_INVALID;
+#if RTOS_STATIC_TASK_TABLE
+static bool staticQueued = false;
+#else
+static uint32_t idleTaskStack[MIN_STACK_SIZE / sizeof(uint32_t)];
+#endif
 
 extern volatile int scheduler_iterations;
 extern volatile int current_task_id;
 
-static void moveToNextTask(void);
-static tcb_t* scheduler_get_next_task(void);
+#if RTOS_STATIC_TASK_TABLE
+static void scheduler_queue_static(void);
+#endif
 
 rtos_result_t scheduler_init(void)
 {
-    taskList = NULL;
+#if RTOS_STATIC_TASK_TABLE
+    /* Ring and idle task are generated at compile time */
+    return RTOS_SUCCESS;
+#else
+    sched_policy_init(&readyQueue);
     schedulerRunning = false;    
   /* Create idle task */
-    idleTaskId = task_create(scheduler_idle_task, "IDLE", MIN_STACK_SIZE);   
+    idleTaskId = task_create_static(scheduler_idle_task, "IDLE",
+                                    idleTaskStack, sizeof(idleTaskStack));
+    task_set_priority(idleTaskId, TASK_PRIORITY_IDLE);
     return RTOS_SUCCESS;
+#endif
 }
 
 void scheduler_start(void)
 {
+#if RTOS_STATIC_TASK_TABLE
+    scheduler_queue_static();
+#endif
+    timer_timebase_init();
+    sliceTicks = timer_calculate_slice_ticks(TIME_SLICE_MS);
+    rrIndex = 0;
     schedulerRunning = true; 
-    tcb_t* firstTask = scheduler_get_next_task();
-    if(firstTask != NULL)
-    {
-        task_set_state(firstTask->task_id, TASK_STATE_RUNNING);
-    }
 }
 
 rtos_result_t scheduler_add_ready_task(tcb_t* tcb)
@@ -36,23 +56,56 @@ rtos_result_t scheduler_add_ready_task(tcb_t* tcb)
     {
         return RTOS_INVALID_PARAM;
     }
-    if(taskList == NULL)
-    {   
-        taskList = tcb;
-        tcb->next = tcb;
-        tcb->prev = tcb;
+#if RTOS_STATIC_TASK_TABLE
+    scheduler_queue_static();
+#endif
+    sched_policy_enqueue(&readyQueue, tcb);
+    return RTOS_SUCCESS;
+}
+
+rtos_result_t scheduler_remove_task(tcb_t* tcb)
+{
+    if(tcb == NULL || tcb->next == NULL)
+    {
+        return RTOS_INVALID_PARAM;
     }
-    else
+    if(tcb->task_id == idleTaskId)
     {
-        tcb_t* tail = taskList->prev;
-        tcb->next = taskList;
-        tcb->prev = tail;
-        tail->next = tcb;
-        taskList->prev = tcb;
+        return RTOS_ERROR;
     }
+#if RTOS_STATIC_TASK_TABLE
+    scheduler_queue_static();
+#endif
+    sched_policy_dequeue(&readyQueue, tcb);
     return RTOS_SUCCESS;
 }
 
+void scheduler_set_task_priority(tcb_t* tcb, uint8_t priority)
+{
+#if SCHED_POLICY_LEVELS > 1
+    /* Queued by priority - move it to its new level */
+    if(tcb->next != NULL && tcb->state != TASK_STATE_DELETED)
+    {
+        ENTER_CRITICAL();
+#if RTOS_STATIC_TASK_TABLE
+        scheduler_queue_static();
+#endif
+        sched_policy_dequeue(&readyQueue, tcb);
+        tcb->priority = priority;
+        sched_policy_enqueue(&readyQueue, tcb);
+        EXIT_CRITICAL();
+        return;
+    }
+#endif
+    tcb->priority = priority;
+}
+
+void scheduler_yield(void)
+{
+    /* Current task gives up the rest of its slice */
+    yieldRequested = true;
+}
+
 bool scheduler_is_running(void)
 {
      return schedulerRunning;
@@ -61,68 +114,110 @@ bool scheduler_is_running(void)
 void scheduler_idle_task(void)
 {
     /* Idle processing - could include power management */
+    task_reap_deleted();
+#if RTOS_USE_HEAP
+    memory_reclaim_deferred();
+#endif
 }
 
-uint8_t scheduler_add_task_fn(scheduler_task_fn_t fn, const char* name, uint32_t stack_size)
+#if RTOS_USE_HEAP
+task_id_t scheduler_add_task_fn(scheduler_task_fn_t fn, const char* name, uint32_t stack_size)
 {
     if (fn == NULL) {
-        return 0xFF;
+        return TASK_ID_INVALID;
     }
     if (stack_size == 0) {
         stack_size = DEFAULT_STACK_SIZE;
     }
     return task_create(fn, (name ? name : "Task"), stack_size);
 }
+#endif /* RTOS_USE_HEAP */
 
 void scheduler_run(void)
 {
     scheduler_start();
-    uint32_t slice_ticks = timer_calculate_slice_ticks(TIME_SLICE_MS);
-    int rr_index = 0;
     for(;;) {
-        scheduler_iterations++;
-        tcb_t* nextTask = scheduler_get_next_task();
-        if (nextTask == NULL) {
-            scheduler_idle_task();
-            continue;
-        }
-        if (nextTask->state == TASK_STATE_BLOCKED || nextTask->state == TASK_STATE_SUSPENDED) {
-            moveToNextTask();
-            continue;
-        }
-        timer_start_slice(slice_ticks);
-        task_set_state(nextTask->task_id, TASK_STATE_RUNNING);
-        current_task_id = rr_index;
-        while (!timer_slice_expired()) {
-            if (nextTask->task_function) {
-                nextTask->task_function();
-            } else {
-                break;
-            }
+        scheduler_step();
+    }
+}
+
+void scheduler_step(void)
+{
+    scheduler_iterations++;
+    uint32_t slice = sliceTicks;
+#if RTOS_TASK_BUDGET
+    tcb_t* nextTask = sched_policy_pick_next(&readyQueue, timer_get_tick_count(), &slice);
+#else
+    tcb_t* nextTask = sched_policy_pick_next(&readyQueue, 0U, &slice);
+#endif
+    if (nextTask == NULL) {
+        /* Blocked, suspended or out of budget - its turn is over */
+        return;
+    }
+#if RTOS_TASK_BUDGET
+    uint64_t sliceStart = time_now_cycles();
+#endif
+    timer_start_slice(slice);
+    task_set_state(nextTask->task_id, TASK_STATE_RUNNING);
+    current_task_id = rrIndex;
+    yieldRequested = false;
+    bool sliceUsed = true;
+    while (!timer_slice_expired()) {
+        /* Task blocked itself on a kernel object or yielded - give up the slice */
+        if (nextTask->state != TASK_STATE_RUNNING || yieldRequested) {
+            sliceUsed = false;
+            break;
         }
-        timer_stop_slice();
-        if (nextTask->state == TASK_STATE_RUNNING) {
-            nextTask->state = TASK_STATE_READY;
+        if (nextTask->stack_pointer == NULL && nextTask->task_function) {
+            /* Stackless task - a plain call on the scheduler's stack */
+            nextTask->task_function();
+        } else if (nextTask->task_function) {
+            /* Each call starts afresh at the top of the task's own stack */
+            cpu_run_on_stack(nextTask->task_function, nextTask->stack_pointer);
+        } else {
+            break;
         }
+    }
+    timer_stop_slice();
+#if RTOS_TASK_BUDGET
+    task_budget_charge(nextTask, (uint32_t)(time_now_cycles() - sliceStart));
+#endif
+#if RTOS_STACK_GUARD
+    task_check_stack_guard(nextTask);
+#endif
+    task_check_timeouts(timer_get_tick_count());
+    if (nextTask->state == TASK_STATE_RUNNING) {
+        nextTask->state = TASK_STATE_READY;
+    }
 
-        moveToNextTask();
-        rr_index = (rr_index + 1) % (task_get_count() ? task_get_count() : 1);
-        if (scheduler_iterations >= 1000) {
-            scheduler_iterations = 0;
-        }}}
-
-static tcb_t* scheduler_get_next_task(void)
-{
-    if(taskList == NULL)
-    {
-        return task_get_tcb(idleTaskId);
+    if (sliceUsed) {
+        sched_policy_tick(&readyQueue, nextTask);
+    } else {
+        sched_policy_yield(&readyQueue, nextTask);
     }
-    return taskList;}
+    rrIndex = (rrIndex + 1) % (task_get_count() ? task_get_count() : 1);
+    if (scheduler_iterations >= 1000) {
+        scheduler_iterations = 0;
+    }}
 
-static void moveToNextTask(void)
+#if RTOS_STATIC_TASK_TABLE
+static void scheduler_queue_static(void)
 {
-    if(taskList == NULL)
+    /* The compile-time table comes linked as one ring from the IDLE slot
+     * (task 0) - sort it into the policy's queue on first use */
+    if(staticQueued)
     {
         return;
     }
-    taskList = taskList->next;}
+    staticQueued = true;
+    idleTaskId = 0;
+    tcb_t* first = task_get_tcb(idleTaskId);
+    tcb_t* tcb = first;
+    do
+    {
+        tcb_t* next = tcb->next;
+        sched_policy_enqueue(&readyQueue, tcb);
+        tcb = next;
+    } while(tcb != first);
+}
+#endif
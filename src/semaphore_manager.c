@@ -0,0 +1,140 @@
+#include "semaphore_manager.h"
+#include "task_manager.h"
+#include "arm_cortex_m.h"
+
+/* ============================================================================
+ * PRIVATE DATA STRUCTURES
+ * ============================================================================ */
+typedef struct {
+    uint32_t          count;
+    uint32_t          max_count;
+    task_wait_list_t  waiters;
+    bool              initialized;
+} semaphore_t;
+
+static semaphore_t semaphores[SEMAPHORE_MAX_COUNT];
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Initialize semaphore subsystem
+ */
+void semaphore_init(void)
+{
+    for (uint8_t i = 0; i < SEMAPHORE_MAX_COUNT; i++) {
+        semaphores[i].count = 0;
+        semaphores[i].max_count = 0;
+        task_wait_list_init(&semaphores[i].waiters);
+        semaphores[i].initialized = false;
+    }
+}
+
+/**
+ * @brief Create a counting semaphore
+ */
+rtos_result_t semaphore_create(uint8_t sem_id, uint32_t initial_count, uint32_t max_count)
+{
+    if (sem_id >= SEMAPHORE_MAX_COUNT || max_count == 0 || initial_count > max_count) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    semaphores[sem_id].count = initial_count;
+    semaphores[sem_id].max_count = max_count;
+    task_wait_list_init(&semaphores[sem_id].waiters);
+    semaphores[sem_id].initialized = true;
+
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Create a binary semaphore (max_count of 1)
+ */
+rtos_result_t semaphore_create_binary(uint8_t sem_id, bool available)
+{
+    return semaphore_create(sem_id, available ? 1U : 0U, 1U);
+}
+
+/**
+ * @brief Take a token
+ */
+rtos_result_t semaphore_take(uint8_t sem_id, uint32_t timeout_ticks)
+{
+    if (sem_id >= SEMAPHORE_MAX_COUNT || !semaphores[sem_id].initialized) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    semaphore_t* sem = &semaphores[sem_id];
+    rtos_result_t result;
+
+    ENTER_CRITICAL();
+
+    /* Woken since the last call: token was handed over, or timed out */
+    if (task_wait_complete(sem, &result)) {
+        EXIT_CRITICAL();
+        return result;
+    }
+
+    /* Fast path: token available */
+    if (sem->count > 0) {
+        sem->count--;
+        EXIT_CRITICAL();
+        return RTOS_SUCCESS;
+    }
+
+    if (timeout_ticks == 0) {
+        EXIT_CRITICAL();
+        return RTOS_TIMEOUT;
+    }
+
+    result = task_block_current(&sem->waiters, sem, timeout_ticks);
+
+    EXIT_CRITICAL();
+
+    /* Not called from a task - nothing to block */
+    return (result == RTOS_BLOCKED) ? RTOS_BLOCKED : RTOS_TIMEOUT;
+}
+
+/**
+ * @brief Give a token, handing it to the highest-priority waiter if any
+ */
+rtos_result_t semaphore_give(uint8_t sem_id)
+{
+    if (sem_id >= SEMAPHORE_MAX_COUNT || !semaphores[sem_id].initialized) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    semaphore_t* sem = &semaphores[sem_id];
+
+    ENTER_CRITICAL();
+
+    /* Wait list is priority ordered - the head is the best waiter */
+    if (sem->waiters.head != NULL) {
+        task_wake(sem->waiters.head, RTOS_SUCCESS);
+        EXIT_CRITICAL();
+        return RTOS_SUCCESS;
+    }
+
+    if (sem->count >= sem->max_count) {
+        EXIT_CRITICAL();
+        return RTOS_ERROR;
+    }
+
+    sem->count++;
+
+    EXIT_CRITICAL();
+
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Read the current token count
+ */
+uint32_t semaphore_get_count(uint8_t sem_id)
+{
+    if (sem_id >= SEMAPHORE_MAX_COUNT || !semaphores[sem_id].initialized) {
+        return 0;
+    }
+    return semaphores[sem_id].count;
+}
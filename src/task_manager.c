@@ -1,86 +1,336 @@
 
   //This module implements task creation and state management for the scheduler.
  
+#include <stddef.h>
 #include "task_manager.h"
 #include "memory_manager.h"
 #include "scheduler.h"
+#include "timer_manager.h"
+#include "arm_cortex_m.h"
 
  // GLOBAL VARIABLES
 
+ // Free-ID bitmap, two levels: bit n of word w set = task ID (w*32 + n) is
+ // free; bit w of the summary set = word w has at least one free ID.
+#define TASK_ID_WORDS           ((MAX_TASKS + 31) / 32)
+#if TASK_ID_WORDS > 32
+#error "Free-ID bitmap supports at most 1024 tasks"
+#endif
+
+ // The dispatch fields must stay one record of four pointers + 4 bytes
+typedef char task_check_tcb_hot[
+    (offsetof(tcb_t, priority) + sizeof(uint8_t) == 4 * sizeof(void*) + 4) ? 1 : -1];
+
+ // Shortest slice a budget may grant (TASK_BUDGET_MIN_SLICE_US in cycles)
+#define TASK_BUDGET_MIN_SLICE   (TASK_BUDGET_MIN_SLICE_US * (SYSTEM_CLOCK_HZ / 1000000U))
+
+ // Words reserved at the low end of every stack for the overflow guard
+#define TASK_STACK_GUARD_WORDS  (RTOS_STACK_GUARD ? 1 : 0)
+
+#if RTOS_STATIC_TASK_TABLE
+#include "task_config.h"
+
+ // Expand RTOS_TASK_LIST (task_config.h) into the task table at compile time.
+ // IDLE always takes slot 0; the ready ring is linked in table order.
+
+#define TASK_STATIC_ONE(name, fn, stack, prio)      + 1
+#define TASK_STATIC_BYTES(name, fn, stack, prio)    + (stack)
+#define TASK_STATIC_INDEX(name, fn, stack, prio)    TASK_INDEX_##name,
+#define TASK_STATIC_STACK(name, fn, stack, prio)                            \
+    static uint32_t task_stack_##name[(stack) / sizeof(uint32_t)]           \
+        __attribute__((aligned(8))) = TASK_STATIC_STACK_INIT((stack) / sizeof(uint32_t)); \
+    typedef char task_check_name_##name[(sizeof(#name) <= MAX_TASK_NAME_LENGTH) ? 1 : -1]; \
+    typedef char task_check_stack_##name[((stack) >= MIN_STACK_SIZE) ? 1 : -1];
+#define TASK_STATIC_TCB(name, fn, stack, prio)                              \
+    [TASK_INDEX_##name] = {                                                 \
+        .task_id = TASK_INDEX_##name,                                       \
+        .task_function = fn,                                                \
+        .state = TASK_STATE_READY,                                          \
+        .priority = prio,                                                   \
+        .stack_pointer = &task_stack_##name[((stack) / sizeof(uint32_t)) & ~1u], \
+        .next = &task_table[(TASK_INDEX_##name + 1) % TASK_STATIC_COUNT],   \
+        .prev = &task_table[(TASK_INDEX_##name + TASK_STATIC_COUNT - 1) % TASK_STATIC_COUNT], \
+    },
+#define TASK_STATIC_INFO(name, fn, stack, prio)                             \
+    [TASK_INDEX_##name] = {                                                 \
+        .task_name = #name,                                                 \
+        .stack_base = task_stack_##name,                                    \
+        .stack_size = (stack),                                              \
+        .stack_static = true,                                               \
+    },
+
+
+ // Stacks are painted by their initializer (this moves them from .bss to
+ // .data, so the image carries the pattern)
+#if RTOS_STACK_PAINT && RTOS_STACK_GUARD
+#define TASK_STATIC_STACK_INIT(words)   { [0] = STACK_GUARD_WORD, [1 ... (words) - 1] = STACK_PAINT_PATTERN }
+#elif RTOS_STACK_PAINT
+#define TASK_STATIC_STACK_INIT(words)   { [0 ... (words) - 1] = STACK_PAINT_PATTERN }
+#elif RTOS_STACK_GUARD
+#define TASK_STATIC_STACK_INIT(words)   { [0] = STACK_GUARD_WORD }
+#else
+#define TASK_STATIC_STACK_INIT(words)   { 0 }
+#endif
+
+#define TASK_STATIC_TASKS       (1 RTOS_TASK_LIST(TASK_STATIC_ONE))
+#define TASK_STATIC_STACK_BYTES (MIN_STACK_SIZE RTOS_TASK_LIST(TASK_STATIC_BYTES))
+
+#if TASK_STATIC_TASKS > MAX_TASKS
+#error "RTOS_TASK_LIST has more tasks (plus IDLE) than MAX_TASKS"
+#endif
+
+enum {
+    TASK_INDEX_IDLE,
+    RTOS_TASK_LIST(TASK_STATIC_INDEX)
+    TASK_STATIC_COUNT
+};
+
+TASK_STATIC_STACK(IDLE, scheduler_idle_task, MIN_STACK_SIZE, TASK_PRIORITY_IDLE)
+RTOS_TASK_LIST(TASK_STATIC_STACK)
+
+static tcb_t task_table[MAX_TASKS] = {
+    TASK_STATIC_TCB(IDLE, scheduler_idle_task, MIN_STACK_SIZE, TASK_PRIORITY_IDLE)
+    RTOS_TASK_LIST(TASK_STATIC_TCB)
+#if TASK_STATIC_TASKS < MAX_TASKS
+    [TASK_STATIC_TASKS ... MAX_TASKS - 1] = {
+        .task_id = TASK_ID_INVALID,
+        .state = TASK_STATE_DELETED,
+    },
+#endif
+};
+static task_info_t task_info[MAX_TASKS] = {
+    TASK_STATIC_INFO(IDLE, scheduler_idle_task, MIN_STACK_SIZE, TASK_PRIORITY_IDLE)
+    RTOS_TASK_LIST(TASK_STATIC_INFO)
+};
+static uint16_t task_count = TASK_STATIC_COUNT;
+
+ // Reject task sets that do not fit the RAM budget (stacks + TCB tables)
+typedef char task_check_ram_budget[
+    (TASK_STATIC_STACK_BYTES + sizeof(task_table) + sizeof(task_info) <= STATIC_TASK_RAM_BUDGET) ? 1 : -1];
+#else
 static tcb_t task_table[MAX_TASKS];
-static uint8_t task_count = 0;
-static uint8_t current_task_id = 0xFF;
+static task_info_t task_info[MAX_TASKS];
+static uint16_t task_count = 0;
+#endif
+static task_id_t current_task_id = TASK_ID_INVALID;
+
+ // ID bitmap and name hash are derived from the table on first use, so the
+ // compile-time table needs no start-up code
+static bool task_index_ready = false;
+static uint32_t task_free_words[TASK_ID_WORDS];
+static uint32_t task_free_summary = 0;
+static task_id_t task_name_hash[TASK_NAME_HASH_SIZE];
+
+ // Deleted tasks waiting for the idle task, linked through tcb->next
+static tcb_t* task_reap_list = NULL;
+
+ // Number of blocked tasks with a timeout - task_check_timeouts() skips the
+ // table scan while this is zero
+static uint16_t task_timed_waits = 0;
 
 
  //PRIVATE FUNCTION PROTOTYPES
 
-static uint8_t task_get_free_id(void);
+static task_id_t task_get_free_id(void);
+static void task_wait_list_remove(tcb_t* tcb);
+static task_id_t task_init_tcb(task_id_t task_id, void (*task_function)(void),
+                               const char* task_name, uint32_t* stack,
+                               uint32_t stack_size, bool stack_static);
+static void task_index_build(void);
+static void task_id_claim(task_id_t task_id);
+static void task_id_release(task_id_t task_id);
+static uint32_t task_name_hash_of(const char* task_name);
+static void task_name_insert(task_id_t task_id);
+static void task_name_remove(task_id_t task_id);
+static void task_stack_prepare(uint32_t* stack, uint32_t stack_size);
  // PUBLIC FUNCTIONS
 
 rtos_result_t task_manager_init(void)
 {
+#if RTOS_STATIC_TASK_TABLE
+    /* Table is fully initialized at compile time */
+    return RTOS_SUCCESS;
+#else
     memset(task_table, 0, sizeof(task_table));
+    memset(task_info, 0, sizeof(task_info));
     
     for(int i = 0; i < MAX_TASKS; i++)
     {
-        task_table[i].task_id = 0xFF;
+        task_table[i].task_id = TASK_ID_INVALID;
         task_table[i].state = TASK_STATE_DELETED;
     }
     
     task_count = 0;
-    current_task_id = 0xFF;
+    current_task_id = TASK_ID_INVALID;
+    task_reap_list = NULL;
+    task_timed_waits = 0;
+    task_index_build();
     
     return RTOS_SUCCESS;
+#endif
 }
 
+#if RTOS_USE_HEAP
  // Create a new task
-uint8_t task_create(void (*task_function)(void), 
-                   const char* task_name, 
-                   uint32_t stack_size)
+task_id_t task_create(void (*task_function)(void), 
+                      const char* task_name, 
+                      uint32_t stack_size)
 {
     if(task_function == NULL || task_name == NULL)
     {
-        return 0xFF;
+        return TASK_ID_INVALID;
     }
     if(stack_size < MIN_STACK_SIZE || task_count >= MAX_TASKS)
     {
-        return 0xFF;
+        return TASK_ID_INVALID;
     }
-    uint8_t task_id = task_get_free_id();
-    if(task_id == 0xFF)
+    /* IDs and stacks of deleted tasks come back only when the idle task
+       reaps them - the caller may be a deleted task still running on its
+       stack, so nothing is reaped here */
+    task_id_t task_id = task_get_free_id();
+    if(task_id == TASK_ID_INVALID)
     {
-        return 0xFF;
+        return TASK_ID_INVALID;
     }
-    tcb_t* tcb = &task_table[task_id];
     
     /* Allocate stack memory */
     uint32_t* stack = (uint32_t*)memory_alloc(stack_size);
     if(stack == NULL)
     {
-        return 0xFF;
+        return TASK_ID_INVALID;
     }
  
-    /* Initialize TCB */
-    tcb->task_id = task_id;
-    strncpy(tcb->task_name, task_name, MAX_TASK_NAME_LENGTH - 1);
-    tcb->task_name[MAX_TASK_NAME_LENGTH - 1] = '\0';
-    tcb->task_function = task_function;
-    tcb->state = TASK_STATE_READY;
-    tcb->stack_base = stack;
-    tcb->stack_size = stack_size;
-    tcb->stack_pointer = stack + (stack_size / sizeof(uint32_t)) - 1;
+    return task_init_tcb(task_id, task_function, task_name, stack, stack_size, false);
+}
+#endif /* RTOS_USE_HEAP */
+
+ // Create a new task on a caller-supplied stack (no heap allocation)
+task_id_t task_create_static(void (*task_function)(void), 
+                             const char* task_name, 
+                             uint32_t* stack,
+                             uint32_t stack_size)
+{
+    if(task_function == NULL || task_name == NULL || stack == NULL)
+    {
+        return TASK_ID_INVALID;
+    }
+    if(stack_size < MIN_STACK_SIZE || task_count >= MAX_TASKS)
+    {
+        return TASK_ID_INVALID;
+    }
+    task_id_t task_id = task_get_free_id();
+    if(task_id == TASK_ID_INVALID)
+    {
+        return TASK_ID_INVALID;
+    }
     
-    task_count++;
+    return task_init_tcb(task_id, task_function, task_name, stack, stack_size, true);
+}
+
+ // Create a task without a stack of its own
+ // The scheduler calls it on its own stack, so nothing on the C stack
+ // survives between calls (coroutine tasks keep their state in statics).
+task_id_t task_create_stackless(void (*task_function)(void),
+                                const char* task_name)
+{
+    if(task_function == NULL || task_name == NULL || task_count >= MAX_TASKS)
+    {
+        return TASK_ID_INVALID;
+    }
+    task_id_t task_id = task_get_free_id();
+    if(task_id == TASK_ID_INVALID)
+    {
+        return TASK_ID_INVALID;
+    }
     
-    /* Add task to scheduler ready list */
-    scheduler_add_ready_task(tcb);
+    return task_init_tcb(task_id, task_function, task_name, NULL, 0, true);
+}
+
+ // Delete a task
+ // The TCB is unlinked from the ready ring and any wait list right away; the
+ // stack and the task ID are reclaimed later by task_reap_deleted().
+ 
+rtos_result_t task_delete(task_id_t task_id)
+{
+    tcb_t* tcb = task_get_tcb(task_id);
     
-    return task_id;
+    if(tcb == NULL)
+    {
+        return RTOS_INVALID_PARAM;
+    }
+    
+    if(!task_index_ready)
+    {
+        task_index_build();
+    }
+    
+    ENTER_CRITICAL();
+    
+    /* Refused for the idle task */
+    if(scheduler_remove_task(tcb) != RTOS_SUCCESS)
+    {
+        EXIT_CRITICAL();
+        return RTOS_ERROR;
+    }
+    
+    task_wait_list_remove(tcb);
+    tcb->wait_object = NULL;
+    tcb->state = TASK_STATE_DELETED;
+    tcb->next = task_reap_list;
+    task_reap_list = tcb;
+    task_count--;
+    
+    EXIT_CRITICAL();
+    
+    task_name_remove(task_id);
+    
+    return RTOS_SUCCESS;
+}
+
+ // Reclaim stacks and IDs of deleted tasks (called by the idle task)
+ // Never call it from a task that may have deleted itself - it would free
+ // the stack it is running on.
+ 
+void task_reap_deleted(void)
+{
+    if(task_reap_list == NULL)
+    {
+        return;
+    }
+    
+    ENTER_CRITICAL();
+    tcb_t* pending = task_reap_list;
+    task_reap_list = NULL;
+    EXIT_CRITICAL();
+    
+    while(pending != NULL)
+    {
+        tcb_t* tcb = pending;
+        task_id_t task_id = tcb->task_id;
+        task_info_t* info = &task_info[task_id];
+        
+        pending = tcb->next;
+        
+#if RTOS_USE_HEAP
+        if(!info->stack_static)
+        {
+            memory_free(info->stack_base);
+        }
+#endif
+        info->stack_base = NULL;
+        tcb->stack_pointer = NULL;
+        tcb->next = NULL;
+        tcb->task_id = TASK_ID_INVALID;
+        
+        ENTER_CRITICAL();
+        task_id_release(task_id);
+        EXIT_CRITICAL();
+    }
 }
 
  // Get task control block by ID
  
-tcb_t* task_get_tcb(uint8_t task_id)
+tcb_t* task_get_tcb(task_id_t task_id)
 {
     if(task_id >= MAX_TASKS)
     {
@@ -95,11 +345,51 @@ tcb_t* task_get_tcb(uint8_t task_id)
     return &task_table[task_id];
 }
 
+ //Get cold task data (name, stack) by ID
+ 
+task_info_t* task_get_info(task_id_t task_id)
+{
+    if(task_get_tcb(task_id) == NULL)
+    {
+        return NULL;
+    }
+    
+    return &task_info[task_id];
+}
+
+ //Find a task by name
+ 
+task_id_t task_find_by_name(const char* task_name)
+{
+    if(task_name == NULL)
+    {
+        return TASK_ID_INVALID;
+    }
+    
+    if(!task_index_ready)
+    {
+        task_index_build();
+    }
+    
+    task_id_t task_id = task_name_hash[task_name_hash_of(task_name)];
+    
+    while(task_id != TASK_ID_INVALID)
+    {
+        if(strncmp(task_info[task_id].task_name, task_name, MAX_TASK_NAME_LENGTH) == 0)
+        {
+            return task_id;
+        }
+        task_id = task_info[task_id].name_next;
+    }
+    
+    return TASK_ID_INVALID;
+}
+
   //Get current running task
  
 tcb_t* task_get_current(void)
 {
-    if(current_task_id == 0xFF)
+    if(current_task_id == TASK_ID_INVALID)
     {
         return NULL;
     }
@@ -109,7 +399,7 @@ tcb_t* task_get_current(void)
 
 // Set task state
  
-rtos_result_t task_set_state(uint8_t task_id, task_state_t new_state)
+rtos_result_t task_set_state(task_id_t task_id, task_state_t new_state)
 {
     if(task_id >= MAX_TASKS)
     {
@@ -129,28 +419,629 @@ rtos_result_t task_set_state(uint8_t task_id, task_state_t new_state)
     {
         current_task_id = task_id;
     }
+#if RTOS_SCHED_POLICY != SCHED_POLICY_RR
+    else if(new_state == TASK_STATE_READY && current_task_id != TASK_ID_INVALID &&
+            task_table[current_task_id].state == TASK_STATE_RUNNING &&
+            tcb->priority > task_table[current_task_id].priority)
+    {
+        /* A more important task is ready - end the running slice after
+         * the current call */
+        scheduler_yield();
+    }
+#endif
+    
+    return RTOS_SUCCESS;
+}
+// Set task priority
+ 
+rtos_result_t task_set_priority(task_id_t task_id, uint8_t priority)
+{
+    if(task_id >= MAX_TASKS || priority > MAX_TASK_PRIORITY)
+    {
+        return RTOS_INVALID_PARAM;
+    }
+    
+    if(task_table[task_id].state == TASK_STATE_DELETED)
+    {
+        return RTOS_ERROR;
+    }
+    
+    scheduler_set_task_priority(&task_table[task_id], priority);
     
     return RTOS_SUCCESS;
 }
  //Get number of active tasks
  
-uint8_t task_get_count(void)
+uint16_t task_get_count(void)
 {
     return task_count;
 }
 
+ // Peak stack use in bytes
+ // Scans up from the low end while the paint pattern is intact - the scan
+ // stops at the deepest word the task ever wrote, so it only reads the
+ // unused part. Without painting the whole stack is reported as used.
+ 
+uint32_t task_get_stack_high_water(task_id_t task_id)
+{
+    task_info_t* info = task_get_info(task_id);
+    
+    if(info == NULL || info->stack_base == NULL)
+    {
+        return 0;
+    }
+    
+    const uint32_t* end = info->stack_base + info->stack_size / sizeof(uint32_t);
+    const uint32_t* p = info->stack_base + TASK_STACK_GUARD_WORDS;
+    
+#if RTOS_STACK_PAINT
+    while(p < end && *p == STACK_PAINT_PATTERN)
+    {
+        p++;
+    }
+#endif
+    
+    return (uint32_t)(end - p) * sizeof(uint32_t);
+}
+
+ // Check the overflow guard after a slice
+ // A task that ran past its stack limit has already corrupted the memory
+ // below it; it is taken off its wait list and suspended so it cannot run
+ // again. Returns true if the guard was overwritten.
+ 
+bool task_check_stack_guard(tcb_t* tcb)
+{
+#if RTOS_STACK_GUARD
+    task_info_t* info = &task_info[tcb->task_id];
+    
+    if(info->stack_base == NULL || info->stack_base[0] == STACK_GUARD_WORD)
+    {
+        return false;
+    }
+    
+    ENTER_CRITICAL();
+    task_wait_list_remove(tcb);
+    tcb->wait_object = NULL;
+    tcb->state = TASK_STATE_SUSPENDED;
+    EXIT_CRITICAL();
+    info->stack_overflow = true;
+    
+    return true;
+#else
+    (void)tcb;
+    return false;
+#endif
+}
+
+ // Stack report
+ // Recommended size = peak use + guard + STACK_REPORT_MARGIN, rounded up to
+ // 8 bytes and never below MIN_STACK_SIZE. Only meaningful after the tasks
+ // have run through their deepest paths.
+ 
+uint16_t task_stack_report(task_stack_report_t* report, uint16_t max_entries)
+{
+    uint16_t count = 0;
+    
+    if(report == NULL)
+    {
+        return 0;
+    }
+    
+    for(task_id_t i = 0; i < MAX_TASKS && count < max_entries; i++)
+    {
+        task_info_t* info = task_get_info(i);
+        
+        if(info == NULL)
+        {
+            continue;
+        }
+        
+        uint32_t used = task_get_stack_high_water(i);
+        uint32_t recommended = used + TASK_STACK_GUARD_WORDS * sizeof(uint32_t)
+                               + STACK_REPORT_MARGIN;
+        recommended = (recommended + 7u) & ~7u;
+        if(recommended < MIN_STACK_SIZE)
+        {
+            recommended = MIN_STACK_SIZE;
+        }
+        
+        report[count].task_id = i;
+        report[count].task_name = info->task_name;
+        report[count].stack_size = info->stack_size;
+        report[count].stack_used = used;
+        report[count].stack_recommended = recommended;
+        report[count].stack_overflow = info->stack_overflow;
+        count++;
+    }
+    
+    return count;
+}
+
+#if RTOS_TASK_BUDGET
+ // Set a CPU budget
+ // The first period starts now with the full budget. budget_us 0 removes the
+ // budget; the overrun statistics are cleared either way.
+
+rtos_result_t task_set_budget(task_id_t task_id, uint32_t budget_us, uint32_t period_ticks)
+{
+    if(task_id >= MAX_TASKS ||
+       (budget_us != 0 && (period_ticks == 0 || budget_us < TASK_BUDGET_MIN_SLICE_US)) ||
+       budget_us > (uint32_t)INT32_MAX / (SYSTEM_CLOCK_HZ / 1000000U))
+    {
+        return RTOS_INVALID_PARAM;
+    }
+    
+    if(task_table[task_id].state == TASK_STATE_DELETED)
+    {
+        return RTOS_ERROR;
+    }
+    
+    task_budget_t* budget = &task_table[task_id].budget;
+    
+    memset(budget, 0, sizeof(*budget));
+    memset(&task_info[task_id].budget, 0, sizeof(task_info[task_id].budget));
+    if(budget_us != 0)
+    {
+        budget->budget = time_us_to_cycles(budget_us);
+        budget->period = period_ticks;
+        budget->remaining = (int32_t)budget->budget;
+        budget->next_refill = timer_get_tick_count() + period_ticks;
+    }
+    
+    return RTOS_SUCCESS;
+}
+
+ // Slice length under the budget
+ // Replenishment is deferrable-server style: at each period boundary the
+ // budget is topped up to full, unused time is not carried over. Time owed
+ // from an overrun is paid back first, so a task that overshoots loses
+ // the same amount from its next period(s). Reads only the TCB, as it runs
+ // for every candidate the policy looks at.
+
+uint32_t task_budget_slice(tcb_t* tcb, uint32_t slice_cycles, uint32_t now)
+{
+    task_budget_t* budget = &tcb->budget;
+    
+    if(budget->budget == 0)
+    {
+        return slice_cycles;
+    }
+    
+    if((int32_t)(now - budget->next_refill) >= 0)
+    {
+        /* Every boundary passed since the last refill pays back */
+        uint32_t periods = (now - budget->next_refill) / budget->period + 1;
+        int64_t remaining = (int64_t)budget->remaining + (int64_t)periods * budget->budget;
+        
+        if(remaining > (int64_t)budget->budget)
+        {
+            remaining = budget->budget;
+        }
+        budget->remaining = (int32_t)remaining;
+        budget->next_refill += periods * budget->period;
+        budget->throttled = (budget->remaining <= 0);
+    }
+    
+    if(budget->throttled)
+    {
+        return 0;
+    }
+    
+    /* Too little left for a slice the timer can time - used up */
+    if(budget->remaining < (int32_t)TASK_BUDGET_MIN_SLICE)
+    {
+        budget->throttled = true;
+        task_info[tcb->task_id].budget.exhausted++;
+        return 0;
+    }
+    
+    return ((uint32_t)budget->remaining < slice_cycles) ? (uint32_t)budget->remaining
+                                                        : slice_cycles;
+}
+
+ // Charge a slice to the budget
+ // The scheduler only checks the slice between calls of the task function,
+ // so the last call can run on past the end of the budget; an overshoot
+ // beyond TASK_BUDGET_SLACK_US is recorded as an overrun.
+
+void task_budget_charge(tcb_t* tcb, uint32_t used_cycles)
+{
+    task_budget_t* budget = &tcb->budget;
+    
+    if(budget->budget == 0)
+    {
+        return;
+    }
+    
+    int64_t remaining = (int64_t)budget->remaining - used_cycles;
+    
+    budget->remaining = (remaining < INT32_MIN) ? INT32_MIN : (int32_t)remaining;
+    
+    if(remaining <= 0)
+    {
+        uint32_t overshoot = (remaining < -(int64_t)UINT32_MAX) ? UINT32_MAX
+                                                                : (uint32_t)-remaining;
+        task_budget_stats_t* stats = &task_info[tcb->task_id].budget;
+        
+        budget->throttled = true;
+        stats->exhausted++;
+        if(overshoot > time_us_to_cycles(TASK_BUDGET_SLACK_US))
+        {
+            stats->overruns++;
+        }
+        if(overshoot > stats->overrun_max)
+        {
+            stats->overrun_max = overshoot;
+        }
+    }
+}
+#endif
+
+ //Initialize an empty wait list
+
+void task_wait_list_init(task_wait_list_t* list)
+{
+    if(list == NULL)
+    {
+        return;
+    }
+
+    list->head = NULL;
+    list->tail = NULL;
+}
+
+ //Block the current task on a wait list
+ //The task function must return after this; the scheduler skips the task
+ //until task_wake() is called for it or the timeout expires.
+
+rtos_result_t task_block_current(task_wait_list_t* list, void* wait_object,
+                                 uint32_t timeout_ticks)
+{
+    tcb_t* tcb = task_get_current();
+
+    if(list == NULL || tcb == NULL || tcb->state != TASK_STATE_RUNNING)
+    {
+        return RTOS_ERROR;
+    }
+
+    tcb->wait_object = wait_object;
+    tcb->wait_result = RTOS_BLOCKED;
+    tcb->wait_list = list;
+    tcb->wait_timed = (timeout_ticks != RTOS_WAIT_FOREVER);
+    tcb->wake_tick = timer_get_tick_count() + timeout_ticks;
+    if(tcb->wait_timed)
+    {
+        task_timed_waits++;
+    }
+
+    /* Insert behind all waiters of equal or higher priority */
+    tcb_t* after = list->tail;
+    while(after != NULL && after->priority < tcb->priority)
+    {
+        after = after->wait_prev;
+    }
+
+    tcb->wait_prev = after;
+    if(after != NULL)
+    {
+        tcb->wait_next = after->wait_next;
+        after->wait_next = tcb;
+    }
+    else
+    {
+        tcb->wait_next = list->head;
+        list->head = tcb;
+    }
+
+    if(tcb->wait_next != NULL)
+    {
+        tcb->wait_next->wait_prev = tcb;
+    }
+    else
+    {
+        list->tail = tcb;
+    }
+
+    task_set_state(tcb->task_id, TASK_STATE_BLOCKED);
+
+    return RTOS_BLOCKED;
+}
+
+ //Remove a task from its wait list and make it ready
+
+void task_wake(tcb_t* tcb, rtos_result_t result)
+{
+    if(tcb == NULL || tcb->wait_list == NULL)
+    {
+        return;
+    }
+
+    task_wait_list_remove(tcb);
+    tcb->wait_result = result;
+
+    task_set_state(tcb->task_id, TASK_STATE_READY);
+}
+
+ //Collect the result of a finished wait on wait_object for the current task
+ //Returns false if the current task has no completed wait on that object.
+
+bool task_wait_complete(void* wait_object, rtos_result_t* result)
+{
+    tcb_t* tcb = task_get_current();
+
+    if(tcb == NULL || wait_object == NULL || tcb->wait_object != wait_object)
+    {
+        return false;
+    }
+
+    if(tcb->wait_result == RTOS_BLOCKED)
+    {
+        return false;
+    }
+
+    if(result != NULL)
+    {
+        *result = tcb->wait_result;
+    }
+    tcb->wait_object = NULL;
+
+    return true;
+}
+
+ //Wake blocked tasks whose timeout has expired at tick 'now'
+
+void task_check_timeouts(uint32_t now)
+{
+    if(task_timed_waits == 0)
+    {
+        return;
+    }
+
+    ENTER_CRITICAL();
+
+    for(uint16_t i = 0; i < MAX_TASKS; i++)
+    {
+        tcb_t* tcb = &task_table[i];
+
+        if(tcb->state == TASK_STATE_BLOCKED && tcb->wait_timed &&
+           (int32_t)(now - tcb->wake_tick) >= 0)
+        {
+            task_wake(tcb, RTOS_TIMEOUT);
+        }
+    }
+
+    EXIT_CRITICAL();
+}
+
  // PRIVATE FUNCTIONS
+// Fill in a free TCB and hand it to the scheduler
+ 
+static task_id_t task_init_tcb(task_id_t task_id, void (*task_function)(void),
+                               const char* task_name, uint32_t* stack,
+                               uint32_t stack_size, bool stack_static)
+{
+    tcb_t* tcb = &task_table[task_id];
+    task_info_t* info = &task_info[task_id];
+    
+    tcb->task_id = task_id;
+    tcb->task_function = task_function;
+    tcb->state = TASK_STATE_READY;
+    tcb->priority = DEFAULT_TASK_PRIORITY;
+    /* Initial SP: top of the stack, rounded down to 8 bytes (AAPCS) */
+    tcb->stack_pointer = NULL;
+    if(stack != NULL)
+    {
+        tcb->stack_pointer = (uint32_t*)((uintptr_t)(stack + stack_size / sizeof(uint32_t))
+                                         & ~(uintptr_t)7);
+        task_stack_prepare(stack, stack_size);
+    }
+    tcb->wait_object = NULL;
+    tcb->wait_list = NULL;
+    tcb->wait_timed = false;
+    
+    strncpy(info->task_name, task_name, MAX_TASK_NAME_LENGTH - 1);
+    info->task_name[MAX_TASK_NAME_LENGTH - 1] = '\0';
+    info->stack_base = stack;
+    info->stack_size = stack_size;
+    info->stack_static = stack_static;
+    info->stack_overflow = false;
+#if RTOS_TASK_BUDGET
+    memset(&tcb->budget, 0, sizeof(tcb->budget));
+    memset(&info->budget, 0, sizeof(info->budget));
+#endif
+    
+    task_count++;
+    ENTER_CRITICAL();
+    task_id_claim(task_id);
+    EXIT_CRITICAL();
+    task_name_insert(task_id);
+    
+    /* Add task to scheduler ready list */
+    scheduler_add_ready_task(tcb);
+    
+    return task_id;
+}
+
 // Get next available task ID
  
-static uint8_t task_get_free_id(void)
+static task_id_t task_get_free_id(void)
+{
+    if(!task_index_ready)
+    {
+        task_index_build();
+    }
+    
+    if(task_free_summary == 0)
+    {
+        return TASK_ID_INVALID;
+    }
+    
+    uint32_t word = (uint32_t)__builtin_ctz(task_free_summary);
+    uint32_t bit = (uint32_t)__builtin_ctz(task_free_words[word]);
+    
+    return (task_id_t)(word * 32U + bit);
+}
+
+// Unlink a task from the wait list it is blocked on, if any
+ 
+static void task_wait_list_remove(tcb_t* tcb)
 {
-    for(uint8_t i = 0; i < MAX_TASKS; i++)
+    task_wait_list_t* list = tcb->wait_list;
+
+    if(list == NULL)
+    {
+        return;
+    }
+
+    if(tcb->wait_prev != NULL)
+    {
+        tcb->wait_prev->wait_next = tcb->wait_next;
+    }
+    else
+    {
+        list->head = tcb->wait_next;
+    }
+
+    if(tcb->wait_next != NULL)
+    {
+        tcb->wait_next->wait_prev = tcb->wait_prev;
+    }
+    else
+    {
+        list->tail = tcb->wait_prev;
+    }
+
+    if(tcb->wait_timed)
+    {
+        task_timed_waits--;
+    }
+
+    tcb->wait_list = NULL;
+    tcb->wait_timed = false;
+    tcb->wait_next = NULL;
+    tcb->wait_prev = NULL;
+}
+
+// Rebuild the free-ID bitmap and name hash from the task table
+ 
+static void task_index_build(void)
+{
+    task_free_summary = 0;
+    memset(task_free_words, 0, sizeof(task_free_words));
+    
+    for(uint16_t i = 0; i < TASK_NAME_HASH_SIZE; i++)
+    {
+        task_name_hash[i] = TASK_ID_INVALID;
+    }
+    
+    task_index_ready = true;
+    
+    for(task_id_t i = 0; i < MAX_TASKS; i++)
     {
-        if(task_table[i].state == TASK_STATE_DELETED)
+        /* Deleted but unreaped tasks keep their ID until the idle task runs */
+        if(task_table[i].task_id == TASK_ID_INVALID)
         {
-            return i;
+            task_id_release(i);
         }
+        else if(task_table[i].state != TASK_STATE_DELETED)
+        {
+            task_name_insert(i);
+        }
+    }
+}
+
+// Mark an ID as used (call with interrupts disabled)
+ 
+static void task_id_claim(task_id_t task_id)
+{
+    uint32_t word = task_id / 32U;
+    
+    task_free_words[word] &= ~(1U << (task_id % 32U));
+    if(task_free_words[word] == 0)
+    {
+        task_free_summary &= ~(1U << word);
+    }
+}
+
+// Mark an ID as free (call with interrupts disabled)
+ 
+static void task_id_release(task_id_t task_id)
+{
+    uint32_t word = task_id / 32U;
+    
+    task_free_words[word] |= (1U << (task_id % 32U));
+    task_free_summary |= (1U << word);
+}
+
+// FNV-1a hash of a task name, reduced to a bucket index
+ 
+static uint32_t task_name_hash_of(const char* task_name)
+{
+    uint32_t hash = 2166136261U;
+    
+    for(uint32_t i = 0; i < MAX_TASK_NAME_LENGTH && task_name[i] != '\0'; i++)
+    {
+        hash ^= (uint8_t)task_name[i];
+        hash *= 16777619U;
     }
     
-    return 0xFF;
+    return hash & (TASK_NAME_HASH_SIZE - 1U);
+}
+
+// Add a task to the head of its name-hash bucket
+ 
+static void task_name_insert(task_id_t task_id)
+{
+    uint32_t bucket = task_name_hash_of(task_info[task_id].task_name);
+    task_id_t head = task_name_hash[bucket];
+    
+    task_info[task_id].name_next = head;
+    task_info[task_id].name_prev = TASK_ID_INVALID;
+    if(head != TASK_ID_INVALID)
+    {
+        task_info[head].name_prev = task_id;
+    }
+    task_name_hash[bucket] = task_id;
+}
+
+// Write the guard word and paint pattern into a new stack
+ 
+static void task_stack_prepare(uint32_t* stack, uint32_t stack_size)
+{
+    uint32_t words = stack_size / sizeof(uint32_t);
+    uint32_t i = 0;
+    
+#if RTOS_STACK_GUARD
+    stack[i++] = STACK_GUARD_WORD;
+#endif
+#if RTOS_STACK_PAINT
+    for(; i < words; i++)
+    {
+        stack[i] = STACK_PAINT_PATTERN;
+    }
+#endif
+    (void)i;
+    (void)words;
+}
+
+// Remove a task from its name-hash bucket (O(1), chains are doubly linked
+// because many workers may share one name)
+ 
+static void task_name_remove(task_id_t task_id)
+{
+    task_info_t* info = &task_info[task_id];
+    
+    if(info->name_prev != TASK_ID_INVALID)
+    {
+        task_info[info->name_prev].name_next = info->name_next;
+    }
+    else
+    {
+        task_name_hash[task_name_hash_of(info->task_name)] = info->name_next;
+    }
+    
+    if(info->name_next != TASK_ID_INVALID)
+    {
+        task_info[info->name_next].name_prev = info->name_prev;
+    }
 }
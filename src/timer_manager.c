@@ -3,7 +3,104 @@
 
 
 #include "timer_manager.h"
+#include "task_manager.h"
 #include "arm_cortex_m.h"
+#if RTOS_PORT_HOST
+#include <time.h>
+#endif
+
+#define CYCLES_PER_TICK     (SYSTEM_CLOCK_HZ / RTOS_TICK_RATE_HZ)
+
+// Q32 fixed-point conversion factors. Reciprocals are rounded up, so the
+// truncated product is the exact quotient or one above it
+#define TIME_TICKS_PER_CYCLE_Q32    (((1ULL << 32) + CYCLES_PER_TICK - 1U) / CYCLES_PER_TICK)
+#define TIME_US_PER_CYCLE_Q32       (((1000000ULL << 32) + SYSTEM_CLOCK_HZ - 1U) / SYSTEM_CLOCK_HZ)
+#define TIME_CYCLES_PER_US_Q32      (((uint64_t)SYSTEM_CLOCK_HZ << 32) / 1000000U)
+#define TIME_CYCLES_PER_NS_Q32      (((uint64_t)SYSTEM_CLOCK_HZ << 32) / 1000000000U)
+#define TIME_TICKS_PER_NS_Q32       ((((uint64_t)RTOS_TICK_RATE_HZ << 32) + 999999999U) / 1000000000U)
+
+// Timebase state at the last update. There are two copies: the writer
+// (scheduler loop, after each slice) fills the inactive one and then flips
+// timebase_index, so a reader - task or ISR - always sees a complete copy
+// and never needs a critical section.
+typedef struct {
+    uint64_t cycles;            /* cycles at the last update */
+    uint64_t ticks;             /* whole kernel ticks at the last update */
+    uint32_t tick_cycles;       /* cycles into the current tick */
+    uint32_t cyccnt;            /* DWT: CYCCNT at the last update */
+    uint32_t slice_reload;      /* SysTick: reload of the running slice, 0 if none */
+} timer_timebase_t;
+
+static volatile timer_timebase_t timebase[2];
+static volatile uint8_t timebase_index = 0;
+#if !RTOS_PORT_HOST
+static bool timebase_dwt = false;
+#if RTOS_PROFILER
+// Profiler builds: SysTick interrupts once per sample period, and the slice
+// is counted down in whole periods
+#define SLICE_PERIOD_CYCLES     (SYSTEM_CLOCK_HZ / PROFILER_SAMPLE_HZ)
+static volatile uint32_t slice_periods_left = 0;
+static volatile uint32_t slice_periods_done = 0;
+#else
+// SysTick wraps (COUNTFLAG) seen in the running slice - the counter keeps
+// running past the end of the slice until timer_stop_slice()
+static volatile uint32_t slice_wraps = 0;
+#endif
+#else
+static uint64_t slice_deadline = 0;
+static struct timespec timebase_epoch;
+#endif
+static uint32_t slice_reload = 0;
+static volatile bool slice_expired = false;
+
+// Software timers. Started timers sit in a list sorted by expiry tick, so
+// the daemon only ever looks at the head. The list is touched from thread
+// context only - ISRs post commands to a small ring that the daemon drains.
+typedef struct soft_timer {
+    struct soft_timer* next;
+    soft_timer_callback_t callback;
+    void* arg;
+    uint32_t period;
+    uint32_t expiry;
+    bool periodic;
+    bool active;                /* started, from the user's point of view */
+    bool linked;                /* in soft_timer_list */
+    bool due;                   /* in the daemon's current batch */
+} soft_timer_t;
+
+typedef enum {
+    SOFT_TIMER_CMD_START,
+    SOFT_TIMER_CMD_STOP,
+    SOFT_TIMER_CMD_RESET
+} soft_timer_cmd_type_t;
+
+typedef struct {
+    uint32_t tick;              /* when the ISR posted it */
+    uint8_t timer_id;
+    uint8_t command;
+} soft_timer_cmd_t;
+
+static soft_timer_t soft_timers[SOFT_TIMER_MAX_COUNT];
+static soft_timer_t* soft_timer_list = NULL;
+static soft_timer_cmd_t soft_timer_cmds[SOFT_TIMER_CMD_QUEUE_SIZE];
+static uint8_t soft_timer_cmd_head = 0;
+static uint8_t soft_timer_cmd_count = 0;
+static task_wait_list_t soft_timer_wait;
+static uint32_t soft_timer_stack[SOFT_TIMER_STACK_SIZE / sizeof(uint32_t)];
+static task_id_t soft_timer_task = TASK_ID_INVALID;
+
+#if !RTOS_PORT_HOST
+static uint32_t timer_cycles_since(const volatile timer_timebase_t* tb);
+static uint32_t timer_slice_elapsed(void);
+static void timer_timebase_publish(uint32_t elapsed, uint32_t cyccnt, uint32_t reload);
+#endif
+static soft_timer_t* soft_timer_get(uint8_t timer_id);
+static rtos_result_t soft_timer_command(uint8_t timer_id, uint8_t command);
+static rtos_result_t soft_timer_command_from_isr(uint8_t timer_id, uint8_t command);
+static void soft_timer_apply(soft_timer_t* timer, uint8_t command, uint32_t now);
+static void soft_timer_link(soft_timer_t* timer);
+static void soft_timer_unlink(soft_timer_t* timer);
+static void soft_timer_daemon(void);
 
 //Calculate SysTick reload value for given time slice in milliseconds
 //This is general
@@ -23,15 +120,32 @@ uint32_t timer_calculate_slice_ticks(uint32_t time_slice_ms)
     return slice_ticks;
 }
 
+#if !RTOS_PORT_HOST
 //Start SysTick timer with given reload value (polling mode)
  //This is for CortexM3
  
 void timer_start_slice(uint32_t reload_ticks)
 {
+    slice_expired = false;
     SYSTICK_CTRL_REG = 0;                       /* Stop */
+#if RTOS_PROFILER
+    /* Interrupt every sample period, timer_slice_tick() counts down */
+    slice_periods_left = (reload_ticks + SLICE_PERIOD_CYCLES - 1U) / SLICE_PERIOD_CYCLES;
+    slice_periods_done = 0;
+    slice_reload = slice_periods_left * SLICE_PERIOD_CYCLES;
+    SYSTICK_LOAD_REG = SLICE_PERIOD_CYCLES - 1U;
+    SYSTICK_VAL_REG  = 0;
+    SYSTICK_CTRL_REG = SYSTICK_ENABLE | SYSTICK_CLKSOURCE | SYSTICK_TICKINT;
+#else
+    slice_reload = reload_ticks;
+    slice_wraps = 0;
     SYSTICK_LOAD_REG = reload_ticks - 1U;       /* Set reload */
     SYSTICK_VAL_REG  = 0;                       /* Clear current value */
     SYSTICK_CTRL_REG = SYSTICK_ENABLE | SYSTICK_CLKSOURCE; /* Start with CPU clock */
+#endif
+    if (!timebase_dwt) {
+        timer_timebase_publish(0, 0, slice_reload);
+    }
 }
 
 //Stop SysTick timer
@@ -39,7 +153,25 @@ void timer_start_slice(uint32_t reload_ticks)
 
 void timer_stop_slice(void)
 {
+    /* A slice can end early when its task blocks - only count what ran */
+#if RTOS_PROFILER
+    SYSTICK_CTRL_REG = 0;
+    uint32_t elapsed = timer_slice_elapsed();
+    /* A period that ended just now must not tick the next slice */
+    NVIC_INT_CTRL_REG = NVIC_PENDSTCLR;
+#else
+    uint32_t elapsed = timer_slice_elapsed();
     SYSTICK_CTRL_REG = 0;
+#endif
+
+    /* Advance the timebase - with DWT this also keeps CYCCNT from wrapping
+     * unseen (an update is needed at least every 2^32 cycles) */
+    if (timebase_dwt) {
+        uint32_t cyccnt = DWT_CYCCNT_REG;
+        timer_timebase_publish(cyccnt - timebase[timebase_index].cyccnt, cyccnt, 0);
+    } else {
+        timer_timebase_publish(elapsed, 0, 0);
+    }
 }
 
 //Check if current time slice has expired
@@ -47,7 +179,513 @@ void timer_stop_slice(void)
 
 bool timer_slice_expired(void)
 {
-    return ((SYSTICK_CTRL_REG & SYSTICK_COUNTFLAG) != 0);
+#if !RTOS_PROFILER
+    /* COUNTFLAG clears on read - count the wrap for timer_slice_elapsed() */
+    if ((SYSTICK_CTRL_REG & SYSTICK_COUNTFLAG) != 0) {
+        slice_wraps++;
+        slice_expired = true;
+    }
+#endif
+    return slice_expired;
+}
+
+#if RTOS_PROFILER
+//One sample period of the running slice has passed (SysTick interrupt)
+
+void timer_slice_tick(void)
+{
+    slice_periods_done++;
+    if (slice_periods_left != 0U && --slice_periods_left == 0U) {
+        slice_expired = true;
+    }
+}
+#endif
+#else
+//Host port - the slice is a deadline on the monotonic clock
+
+void timer_start_slice(uint32_t reload_ticks)
+{
+    slice_reload = reload_ticks;
+    slice_expired = false;
+    slice_deadline = time_now_cycles() + reload_ticks;
+}
+
+void timer_stop_slice(void)
+{
+    slice_reload = 0;
+}
+
+bool timer_slice_expired(void)
+{
+    if (!slice_expired && time_now_cycles() >= slice_deadline) {
+        slice_expired = true;
+    }
+    return slice_expired;
+}
+#endif
+
+//Get kernel tick count
+
+uint32_t timer_get_tick_count(void)
+{
+    return (uint32_t)time_now_ticks64();
+}
+
+//Start the 64-bit timebase
+
+void timer_timebase_init(void)
+{
+    memset((void*)timebase, 0, sizeof(timebase));
+    timebase_index = 0;
+#if !RTOS_PORT_HOST
+    DEMCR_REG |= DEMCR_TRCENA;
+    if ((DWT_CTRL_REG & DWT_CTRL_NOCYCCNT) == 0U) {
+        DWT_CTRL_REG |= DWT_CTRL_CYCCNTENA;
+        /* Some simulators accept the enable bit but never count */
+        uint32_t start = DWT_CYCCNT_REG;
+        for (volatile int i = 0; i < 4; i++);
+        timebase_dwt = (DWT_CYCCNT_REG != start);
+    }
+    if (timebase_dwt) {
+        timebase[0].cyccnt = DWT_CYCCNT_REG;
+    }
+#else
+    clock_gettime(CLOCK_MONOTONIC, &timebase_epoch);
+#endif
+}
+
+#if RTOS_PORT_HOST
+//Host port - CLOCK_MONOTONIC since timer_timebase_init(), scaled to target
+//cycles and ticks
+
+static void timer_host_since_epoch(struct timespec* ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec -= timebase_epoch.tv_sec;
+    ts->tv_nsec -= timebase_epoch.tv_nsec;
+    if (ts->tv_nsec < 0) {
+        ts->tv_nsec += 1000000000L;
+        ts->tv_sec--;
+    }
+}
+
+uint64_t time_now_cycles(void)
+{
+    struct timespec ts;
+    timer_host_since_epoch(&ts);
+    return (uint64_t)ts.tv_sec * SYSTEM_CLOCK_HZ
+         + (((uint64_t)ts.tv_nsec * TIME_CYCLES_PER_NS_Q32) >> 32);
+}
+
+uint64_t time_now_ticks64(void)
+{
+    struct timespec ts;
+    timer_host_since_epoch(&ts);
+    uint64_t ns = (uint64_t)ts.tv_nsec;
+    uint64_t ticks = (ns * TIME_TICKS_PER_NS_Q32) >> 32;
+    if (ticks * 1000000000U > ns * RTOS_TICK_RATE_HZ) {
+        ticks--;
+    }
+    return (uint64_t)ts.tv_sec * RTOS_TICK_RATE_HZ + ticks;
+}
+#else
+//Current time in cycles
+
+uint64_t time_now_cycles(void)
+{
+    const volatile timer_timebase_t* tb = &timebase[timebase_index];
+    uint64_t cycles = tb->cycles;
+    return cycles + timer_cycles_since(tb);
+}
+
+//Current time in kernel ticks
+
+uint64_t time_now_ticks64(void)
+{
+    const volatile timer_timebase_t* tb = &timebase[timebase_index];
+    uint64_t ticks = tb->ticks;
+    uint32_t tick_cycles = tb->tick_cycles;
+    return ticks + time_cycles_to_ticks(tick_cycles + timer_cycles_since(tb));
+}
+#endif
+
+//Cycles to microseconds
+
+uint32_t time_cycles_to_us(uint32_t cycles)
+{
+    uint32_t us = (uint32_t)(((uint64_t)cycles * TIME_US_PER_CYCLE_Q32) >> 32);
+    if ((uint64_t)us * SYSTEM_CLOCK_HZ > (uint64_t)cycles * 1000000U) {
+        us--;
+    }
+    return us;
+}
+
+//Microseconds to cycles (result must fit in 32 bits)
+
+uint32_t time_us_to_cycles(uint32_t us)
+{
+    return (uint32_t)((uint64_t)us * (uint32_t)(TIME_CYCLES_PER_US_Q32 >> 32)
+                    + (((uint64_t)us * (uint32_t)TIME_CYCLES_PER_US_Q32) >> 32));
+}
+
+//Cycles to whole kernel ticks
+
+uint32_t time_cycles_to_ticks(uint32_t cycles)
+{
+    uint32_t ticks = (uint32_t)(((uint64_t)cycles * TIME_TICKS_PER_CYCLE_Q32) >> 32);
+    if ((uint64_t)ticks * CYCLES_PER_TICK > cycles) {
+        ticks--;
+    }
+    return ticks;
+}
+
+//Kernel ticks to cycles (result must fit in 32 bits)
+
+uint32_t time_ticks_to_cycles(uint32_t ticks)
+{
+    return ticks * CYCLES_PER_TICK;
+}
+
+#if !RTOS_PORT_HOST
+//Cycles elapsed since the update that produced tb
+
+static uint32_t timer_cycles_since(const volatile timer_timebase_t* tb)
+{
+    if (timebase_dwt) {
+        uint32_t cyccnt = tb->cyccnt;
+        return DWT_CYCCNT_REG - cyccnt;
+    }
+    if (tb->slice_reload == 0U) {
+        return 0;
+    }
+    /* Inside a slice: add the part of it that has run so far */
+    return timer_slice_elapsed();
+}
+
+//CPU time used by the running slice, including any time past its end
+
+static uint32_t timer_slice_elapsed(void)
+{
+#if RTOS_PROFILER
+    uint32_t start;
+    uint32_t done;
+    uint32_t val;
+    do {
+        start = slice_periods_done;
+        done = start;
+        val = SYSTICK_VAL_REG;
+        /* Counter wrapped but its interrupt has not run yet */
+        if ((NVIC_INT_CTRL_REG & NVIC_PENDSTSET) != 0U) {
+            val = SYSTICK_VAL_REG;
+            done++;
+        }
+    } while (start != slice_periods_done);      /* interrupt ran meanwhile */
+    return done * SLICE_PERIOD_CYCLES + (SLICE_PERIOD_CYCLES - 1U - val);
+#else
+    /* Each wrap is one more reload of CPU time. One that has not been
+     * counted yet shows in COUNTFLAG, so check it before VAL - and after,
+     * since VAL starts over at the top if the counter wraps in between */
+    timer_slice_expired();
+    uint32_t wraps = slice_wraps;
+    uint32_t val = SYSTICK_VAL_REG;
+    timer_slice_expired();
+    if (slice_wraps != wraps) {
+        val = SYSTICK_VAL_REG;
+    }
+    return slice_wraps * slice_reload + (slice_reload - 1U - val);
+#endif
+}
+
+//Fill the inactive timebase copy and make it current (writer only)
+
+static void timer_timebase_publish(uint32_t elapsed, uint32_t cyccnt, uint32_t reload)
+{
+    const volatile timer_timebase_t* cur = &timebase[timebase_index];
+    uint8_t next = (uint8_t)(timebase_index ^ 1U);
+    volatile timer_timebase_t* tb = &timebase[next];
+    uint32_t tick_cycles = cur->tick_cycles + elapsed;
+    uint32_t ticks = time_cycles_to_ticks(tick_cycles);
+
+    tb->cycles = cur->cycles + elapsed;
+    tb->ticks = cur->ticks + ticks;
+    tb->tick_cycles = tick_cycles - ticks * CYCLES_PER_TICK;
+    tb->cyccnt = cyccnt;
+    tb->slice_reload = reload;
+    timebase_index = next;
+}
+#endif
+
+
+
+//Reset all timers and create the timer daemon task
+
+rtos_result_t soft_timer_init(void)
+{
+    memset(soft_timers, 0, sizeof(soft_timers));
+    soft_timer_list = NULL;
+    soft_timer_cmd_head = 0;
+    soft_timer_cmd_count = 0;
+    task_wait_list_init(&soft_timer_wait);
+
+    if (soft_timer_task == TASK_ID_INVALID) {
+        soft_timer_task = task_create_static(soft_timer_daemon, "TmrSvc",
+                                             soft_timer_stack, sizeof(soft_timer_stack));
+        if (soft_timer_task == TASK_ID_INVALID) {
+            return RTOS_NO_MEMORY;
+        }
+        task_set_priority(soft_timer_task, MAX_TASK_PRIORITY);
+    }
+    return RTOS_SUCCESS;
+}
+
+//Configure a timer, leaves it stopped
+
+rtos_result_t soft_timer_create(uint8_t timer_id, uint32_t period_ticks, bool periodic,
+                                soft_timer_callback_t callback, void* arg)
+{
+    if (timer_id >= SOFT_TIMER_MAX_COUNT || callback == NULL ||
+        period_ticks == 0U || period_ticks > 0x7FFFFFFFU) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    soft_timer_t* timer = &soft_timers[timer_id];
+
+    ENTER_CRITICAL();
+    soft_timer_unlink(timer);
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->period = period_ticks;
+    timer->periodic = periodic;
+    timer->active = false;
+    timer->due = false;
+    EXIT_CRITICAL();
+
+    return RTOS_SUCCESS;
+}
+
+rtos_result_t soft_timer_start(uint8_t timer_id)
+{
+    return soft_timer_command(timer_id, SOFT_TIMER_CMD_START);
+}
+
+rtos_result_t soft_timer_stop(uint8_t timer_id)
+{
+    return soft_timer_command(timer_id, SOFT_TIMER_CMD_STOP);
+}
+
+rtos_result_t soft_timer_reset(uint8_t timer_id)
+{
+    return soft_timer_command(timer_id, SOFT_TIMER_CMD_RESET);
+}
+
+rtos_result_t soft_timer_start_from_isr(uint8_t timer_id)
+{
+    return soft_timer_command_from_isr(timer_id, SOFT_TIMER_CMD_START);
+}
+
+rtos_result_t soft_timer_stop_from_isr(uint8_t timer_id)
+{
+    return soft_timer_command_from_isr(timer_id, SOFT_TIMER_CMD_STOP);
+}
+
+rtos_result_t soft_timer_reset_from_isr(uint8_t timer_id)
+{
+    return soft_timer_command_from_isr(timer_id, SOFT_TIMER_CMD_RESET);
+}
+
+bool soft_timer_is_active(uint8_t timer_id)
+{
+    soft_timer_t* timer = soft_timer_get(timer_id);
+    return (timer != NULL) && timer->active;
+}
+
+//Look up a created timer
+
+static soft_timer_t* soft_timer_get(uint8_t timer_id)
+{
+    if (timer_id >= SOFT_TIMER_MAX_COUNT || soft_timers[timer_id].callback == NULL) {
+        return NULL;
+    }
+    return &soft_timers[timer_id];
 }
 
+//Apply a command from task context right away
 
+static rtos_result_t soft_timer_command(uint8_t timer_id, uint8_t command)
+{
+    soft_timer_t* timer = soft_timer_get(timer_id);
+
+    if (timer == NULL) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    ENTER_CRITICAL();
+    soft_timer_apply(timer, command, timer_get_tick_count());
+    EXIT_CRITICAL();
+
+    return RTOS_SUCCESS;
+}
+
+//Queue a command from an ISR - O(1), the daemon applies it
+
+static rtos_result_t soft_timer_command_from_isr(uint8_t timer_id, uint8_t command)
+{
+    if (soft_timer_get(timer_id) == NULL) {
+        return RTOS_INVALID_PARAM;
+    }
+
+    ENTER_CRITICAL();
+    if (soft_timer_cmd_count >= SOFT_TIMER_CMD_QUEUE_SIZE) {
+        EXIT_CRITICAL();
+        return RTOS_NO_MEMORY;
+    }
+    soft_timer_cmd_t* cmd = &soft_timer_cmds[(soft_timer_cmd_head + soft_timer_cmd_count)
+                                             % SOFT_TIMER_CMD_QUEUE_SIZE];
+    cmd->tick = timer_get_tick_count();
+    cmd->timer_id = timer_id;
+    cmd->command = command;
+    soft_timer_cmd_count++;
+    if (soft_timer_wait.head != NULL) {
+        task_wake(soft_timer_wait.head, RTOS_SUCCESS);
+    }
+    EXIT_CRITICAL();
+
+    return RTOS_SUCCESS;
+}
+
+//Start/stop/reset a timer at tick 'now' (call with interrupts disabled)
+//Any command takes the timer out of a batch the daemon is running.
+
+static void soft_timer_apply(soft_timer_t* timer, uint8_t command, uint32_t now)
+{
+    if (command == SOFT_TIMER_CMD_START && timer->active) {
+        return;
+    }
+
+    soft_timer_unlink(timer);
+    timer->due = false;
+    timer->active = (command != SOFT_TIMER_CMD_STOP);
+    if (timer->active) {
+        timer->expiry = now + timer->period;
+        soft_timer_link(timer);
+    }
+}
+
+//Insert by expiry, after timers due on the same tick (call with interrupts
+//disabled). A new head means the daemon must re-arm its sleep.
+
+static void soft_timer_link(soft_timer_t* timer)
+{
+    soft_timer_t** link = &soft_timer_list;
+
+    while (*link != NULL && (int32_t)(timer->expiry - (*link)->expiry) >= 0) {
+        link = &(*link)->next;
+    }
+    timer->next = *link;
+    *link = timer;
+    timer->linked = true;
+
+    if (soft_timer_list == timer && soft_timer_wait.head != NULL) {
+        task_wake(soft_timer_wait.head, RTOS_SUCCESS);
+    }
+}
+
+//Remove from the sorted list if present (call with interrupts disabled)
+
+static void soft_timer_unlink(soft_timer_t* timer)
+{
+    if (!timer->linked) {
+        return;
+    }
+
+    soft_timer_t** link = &soft_timer_list;
+    while (*link != timer) {
+        link = &(*link)->next;
+    }
+    *link = timer->next;
+    timer->next = NULL;
+    timer->linked = false;
+}
+
+//Timer daemon task
+//Each call drains the ISR commands, takes every timer due by now off the
+//list as one batch, runs their callbacks back to back and then blocks
+//until the next expiry (or a command) - no polling while nothing is due.
+
+static void soft_timer_daemon(void)
+{
+    soft_timer_t* batch[SOFT_TIMER_MAX_COUNT];
+    uint8_t batch_count = 0;
+    rtos_result_t result;
+
+    ENTER_CRITICAL();
+    task_wait_complete(&soft_timer_wait, &result);
+    EXIT_CRITICAL();
+
+    /* One command per critical section keeps ISR latency short */
+    for (;;) {
+        ENTER_CRITICAL();
+        if (soft_timer_cmd_count == 0U) {
+            EXIT_CRITICAL();
+            break;
+        }
+        soft_timer_cmd_t cmd = soft_timer_cmds[soft_timer_cmd_head];
+        soft_timer_cmd_head = (uint8_t)((soft_timer_cmd_head + 1U) % SOFT_TIMER_CMD_QUEUE_SIZE);
+        soft_timer_cmd_count--;
+        soft_timer_apply(&soft_timers[cmd.timer_id], cmd.command, cmd.tick);
+        EXIT_CRITICAL();
+    }
+
+    uint32_t now = timer_get_tick_count();
+
+    ENTER_CRITICAL();
+    while (soft_timer_list != NULL && (int32_t)(now - soft_timer_list->expiry) >= 0) {
+        soft_timer_t* timer = soft_timer_list;
+        soft_timer_list = timer->next;
+        timer->next = NULL;
+        timer->linked = false;
+        timer->due = true;
+        if (!timer->periodic) {
+            timer->active = false;
+        }
+        batch[batch_count++] = timer;
+    }
+    EXIT_CRITICAL();
+
+    for (uint8_t i = 0; i < batch_count; i++) {
+        soft_timer_t* timer = batch[i];
+
+        /* Stopped or restarted by an earlier callback of this batch */
+        if (!timer->due) {
+            continue;
+        }
+        timer->due = false;
+        timer->callback((uint8_t)(timer - soft_timers), timer->arg);
+
+        /* Next period, unless the callback stopped or restarted it; periods
+         * missed while the daemon was held up are skipped, not replayed */
+        if (timer->periodic && timer->active && !timer->linked) {
+            timer->expiry += timer->period;
+            if ((int32_t)(timer->expiry - now) <= 0) {
+                timer->expiry = now + timer->period;
+            }
+            ENTER_CRITICAL();
+            soft_timer_link(timer);
+            EXIT_CRITICAL();
+        }
+    }
+
+    ENTER_CRITICAL();
+    if (soft_timer_cmd_count == 0U) {
+        uint32_t timeout = RTOS_WAIT_FOREVER;
+        if (soft_timer_list != NULL) {
+            int32_t remaining = (int32_t)(soft_timer_list->expiry - timer_get_tick_count());
+            timeout = (remaining > 0) ? (uint32_t)remaining : 0U;
+        }
+        /* Something already due: return and get called again */
+        if (timeout != 0U) {
+            task_block_current(&soft_timer_wait, &soft_timer_wait, timeout);
+        }
+    }
+    EXIT_CRITICAL();
+}
@@ -0,0 +1,135 @@
+#include "work_queue.h"
+#include "task_manager.h"
+#include "arm_cortex_m.h"
+
+/* ============================================================================
+ * PRIVATE DATA STRUCTURES
+ * ============================================================================ */
+
+/* Posted items, newest first. Producers push with compare-and-swap; the
+ * worker takes the whole list with one exchange, so there is no ABA case. */
+static work_item_t* volatile work_queue_head = NULL;
+
+/* The worker sleeps here while the queue is empty */
+static task_wait_list_t work_queue_wait;
+static uint32_t work_queue_stack[WORK_QUEUE_STACK_SIZE / sizeof(uint32_t)];
+static task_id_t work_queue_task = TASK_ID_INVALID;
+
+/* ============================================================================
+ * PRIVATE FUNCTION PROTOTYPES
+ * ============================================================================ */
+static void work_queue_worker(void);
+
+/* ============================================================================
+ * PUBLIC FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create the worker task
+ */
+rtos_result_t work_queue_init(void)
+{
+    if (work_queue_task == TASK_ID_INVALID) {
+        task_wait_list_init(&work_queue_wait);
+        work_queue_task = task_create_static(work_queue_worker, "WorkQ",
+                                             work_queue_stack, sizeof(work_queue_stack));
+        if (work_queue_task == TASK_ID_INVALID) {
+            return RTOS_NO_MEMORY;
+        }
+        task_set_priority(work_queue_task, MAX_TASK_PRIORITY);
+    }
+    return RTOS_SUCCESS;
+}
+
+/**
+ * @brief Set up a work item
+ */
+void work_init(work_item_t* work, work_fn_t fn, void* arg)
+{
+    work->next = NULL;
+    work->fn = fn;
+    work->arg = arg;
+    work->pending = 0;
+}
+
+/**
+ * @brief Queue a work item
+ */
+bool work_post(work_item_t* work)
+{
+    /* Coalesce: only the post that sets the flag links the item */
+    if (__atomic_exchange_n(&work->pending, 1U, __ATOMIC_ACQUIRE) != 0U) {
+        return false;
+    }
+
+    work_item_t* head = __atomic_load_n(&work_queue_head, __ATOMIC_RELAXED);
+    do {
+        work->next = head;
+    } while (!__atomic_compare_exchange_n(&work_queue_head, &head, work, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    /* Only the post that made the queue non-empty can find the worker
+     * asleep, so a burst pays for one short critical section */
+    if (head == NULL) {
+        ENTER_CRITICAL();
+        if (work_queue_wait.head != NULL) {
+            task_wake(work_queue_wait.head, RTOS_SUCCESS);
+        }
+        EXIT_CRITICAL();
+    }
+    return true;
+}
+
+/**
+ * @brief Whether a work item is queued and not yet started
+ */
+bool work_is_pending(const work_item_t* work)
+{
+    return __atomic_load_n(&work->pending, __ATOMIC_RELAXED) != 0U;
+}
+
+/* ============================================================================
+ * PRIVATE FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Worker task - runs everything posted so far as one batch
+ * @note Items posted while a batch runs form the next batch, which the
+ *       scheduler calls for in the same slice. With nothing posted the
+ *       worker blocks until work_post() wakes it, so at the top priority
+ *       it does not keep the tasks below it from running.
+ */
+static void work_queue_worker(void)
+{
+    rtos_result_t result;
+    work_item_t* list = __atomic_exchange_n(&work_queue_head, NULL, __ATOMIC_ACQUIRE);
+
+    if (list == NULL) {
+        ENTER_CRITICAL();
+        task_wait_complete(&work_queue_wait, &result);
+        /* Checked again with interrupts off: a post from here on sees the
+         * worker on the wait list and wakes it */
+        if (__atomic_load_n(&work_queue_head, __ATOMIC_RELAXED) == NULL) {
+            task_block_current(&work_queue_wait, &work_queue_wait, RTOS_WAIT_FOREVER);
+        }
+        EXIT_CRITICAL();
+        return;
+    }
+
+    /* Newest first -> oldest first */
+    work_item_t* batch = NULL;
+    while (list != NULL) {
+        work_item_t* next = list->next;
+        list->next = batch;
+        batch = list;
+        list = next;
+    }
+
+    while (batch != NULL) {
+        work_item_t* work = batch;
+        /* Read the link before the item can be posted again */
+        batch = work->next;
+        __atomic_store_n(&work->pending, 0U, __ATOMIC_RELEASE);
+        work->fn(work->arg);
+    }
+}
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""
+bench_compare - diff two kernel benchmark runs (CSV from bench_write_csv())
+
+Usage:
+  bench_compare.py [-t percent] [-a amount] [-m column] baseline.csv current.csv
+
+  -t  regression threshold in percent (default 10)
+  -a  ignore changes smaller than this, in the units of the column
+      (default 0 - simulator runs are exact; host runs need e.g. -a 50)
+  -m  column to compare (default avg_ns; min_cycles is the least noisy
+      on the host, max_cycles shows worst-case changes)
+
+Prints one line per benchmark and exits with 1 if any benchmark got slower
+than the threshold, or disappeared. Lines starting with '#' are ignored.
+"""
+
+import argparse
+import csv
+import sys
+
+
+def load(path):
+    with open(path, newline="") as f:
+        rows = csv.DictReader(line for line in f if not line.startswith("#"))
+        return {(r["benchmark"], r["tasks"]): r for r in rows}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two benchmark runs")
+    parser.add_argument("-t", "--threshold", type=float, default=10.0)
+    parser.add_argument("-a", "--absolute", type=int, default=0)
+    parser.add_argument("-m", "--metric", default="avg_ns")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    args = parser.parse_args()
+
+    base = load(args.baseline)
+    cur = load(args.current)
+    regressions = 0
+
+    print("%-20s %5s %12s %12s %8s" % ("benchmark", "tasks", "baseline", "current", "change"))
+    for key in sorted(set(base) | set(cur)):
+        name, tasks = key
+        if key not in cur:
+            print("%-20s %5s %12s %12s %8s" % (name, tasks, base[key][args.metric], "-", "MISSING"))
+            regressions += 1
+            continue
+        if key not in base:
+            print("%-20s %5s %12s %12s %8s" % (name, tasks, "-", cur[key][args.metric], "new"))
+            continue
+
+        old = int(base[key][args.metric])
+        new = int(cur[key][args.metric])
+        change = (new - old) * 100.0 / old if old else 0.0
+        flag = ""
+        slower = change > args.threshold and new - old > args.absolute
+        if int(cur[key]["iterations"]) == 0 or slower:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-20s %5s %12d %12d %+7.1f%%%s" % (name, tasks, old, new, change, flag))
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,64 @@
+/*
+ * bench_host - runs the kernel micro-benchmarks (src/benchmark.c) on the host
+ *
+ * Builds the real kernel with the host port and prints the results as CSV
+ * on stdout. Times are in target-clock cycles (SYSTEM_CLOCK_HZ), scaled from
+ * CLOCK_MONOTONIC, so only compare host runs with host runs.
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -DRTOS_PORT_HOST=1 -DRTOS_BENCHMARK=1 -Iinclude -o bench_host \
+ *       tools/bench/bench_host.c src/benchmark.c src/scheduler.c \
+ *       src/task_manager.c src/memory_manager.c src/timer_manager.c \
+ *       src/semaphore_manager.c src/queue_manager.c src/arm_cortex_m.c
+ *
+ * Add -DMAX_TASKS=64 (or 256) to measure the dispatch ring at that size.
+ *
+ * Usage:
+ *   bench_host > results.csv
+ *   python3 tools/bench/bench_compare.py baseline.csv results.csv
+ */
+
+#include <stdio.h>
+
+#include "rtos_config.h"
+#include "task_manager.h"
+#include "scheduler.h"
+#include "memory_manager.h"
+#include "semaphore_manager.h"
+#include "queue_manager.h"
+#include "benchmark.h"
+
+/* Demo counters the scheduler updates (defined by main.c on the target) */
+volatile int scheduler_iterations = 0;
+volatile int current_task_id = 0;
+
+static void write_line(const char* line)
+{
+    puts(line);
+}
+
+int main(void)
+{
+    bench_result_t results[BENCH_MAX_RESULTS];
+
+    memory_init();
+    task_manager_init();
+    scheduler_init();
+    semaphore_init();
+    queue_init();
+
+    uint16_t count = bench_run_all(results, BENCH_MAX_RESULTS);
+    if (count == 0) {
+        fprintf(stderr, "bench_host: clock does not advance\n");
+        return 1;
+    }
+    bench_write_csv(results, count, write_line);
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (results[i].iterations == 0) {
+            fprintf(stderr, "bench_host: %s did not complete\n", results[i].name);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+prof_fold - turn profiler samples into folded stacks for flame graphs
+
+Usage:
+  prof_fold.py --elf FILE [--nm TOOL] samples.txt > prof.folded
+  prof_fold.py --map FILE samples.txt > prof.folded
+
+  --elf  executable to symbolize against (the .axf from Keil, or a host
+         build); symbols are read with nm (default "nm", use
+         "arm-none-eabi-nm" for the target if the host nm cannot read it)
+  --map  armlink map file instead of an ELF (needs the symbol table,
+         "--symbols" / Listing "Symbols" in the Keil project)
+
+samples.txt holds the lines written by profiler_write(), e.g. a saved
+ITM "Debug (printf) Viewer" log or the output of prof_host. Output lines
+are "task;function count", sorted by count, which flamegraph.pl and
+speedscope read directly. Samples outside any known function are
+folded into "[unknown]".
+"""
+
+import argparse
+import bisect
+import re
+import subprocess
+import sys
+from collections import Counter
+
+EM_ARM = 40
+MAP_SYMBOL = re.compile(r"^\s*(\S+)\s+0x([0-9a-fA-F]+)\s+(?:Thumb|ARM) Code\s+(\d+)")
+
+
+def elf_is_arm(path):
+    with open(path, "rb") as f:
+        header = f.read(20)
+    endian = "little" if header[5:6] == b"\x01" else "big"
+    return int.from_bytes(header[18:20], endian) == EM_ARM
+
+
+def symbols_from_elf(path, nm):
+    out = subprocess.run([nm, "-n", "-S", "--defined-only", path],
+                         check=True, capture_output=True, text=True).stdout
+    # Thumb function symbols carry bit 0, other architectures use every bit
+    mask = ~1 if elf_is_arm(path) else ~0
+    syms = []
+    for line in out.splitlines():
+        parts = line.split()
+        # Functions have a size; unsized entries are labels and markers
+        if len(parts) == 4 and parts[2] in "tTwW":
+            addr, size, _, name = parts
+            syms.append((int(addr, 16) & mask, int(size, 16), name))
+    return syms
+
+
+def symbols_from_map(path):
+    syms = []
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = MAP_SYMBOL.match(line)
+            if m:
+                # Thumb code addresses carry bit 0
+                syms.append((int(m.group(2), 16) & ~1, int(m.group(3)), m.group(1)))
+    return syms
+
+
+class Symbolizer:
+    def __init__(self, syms):
+        syms.sort()
+        self.addrs = [s[0] for s in syms]
+        self.syms = syms
+
+    def lookup(self, pc):
+        i = bisect.bisect_right(self.addrs, pc) - 1
+        if i < 0:
+            return "[unknown]"
+        addr, size, name = self.syms[i]
+        if pc >= addr + max(size, 1):
+            return "[unknown]"
+        return name
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Fold profiler samples")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--elf")
+    source.add_argument("--map")
+    parser.add_argument("--nm", default="nm")
+    parser.add_argument("samples")
+    args = parser.parse_args()
+
+    if args.elf:
+        syms = symbols_from_elf(args.elf, args.nm)
+    else:
+        syms = symbols_from_map(args.map)
+    if not syms:
+        sys.exit("prof_fold: no code symbols found")
+    symbolizer = Symbolizer(syms)
+
+    bias = 0
+    dropped = 0
+    folded = Counter()
+    with open(args.samples, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("# profiler"):
+                fields = dict(kv.split("=", 1) for kv in line.split()[2:] if "=" in kv)
+                bias = int(fields.get("bias", "0"), 16)
+                dropped = max(dropped, int(fields.get("dropped", "0")))
+                continue
+            task, sep, pc = line.rpartition(",")
+            if not sep or not pc.startswith("0x"):
+                continue
+            func = symbolizer.lookup(int(pc, 16) - bias)
+            folded["%s;%s" % (task.replace(";", "_"), func)] += 1
+
+    for stack, count in folded.most_common():
+        print("%s %d" % (stack, count))
+    if dropped:
+        print("prof_fold: %d samples were dropped on the target" % dropped, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
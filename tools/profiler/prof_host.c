@@ -0,0 +1,111 @@
+/*
+ * prof_host - the PC-sampling profiler on the host port
+ *
+ * Runs the real scheduler with three tasks that spend their time in
+ * different functions, samples them through SIGPROF and prints the samples
+ * in the same "task,pc" format the target sends over ITM.
+ *
+ * Build and fold (from the repository root):
+ *   gcc -O1 -g -DRTOS_PORT_HOST=1 -DRTOS_PROFILER=1 -Iinclude -o prof_host \
+ *       tools/profiler/prof_host.c src/profiler.c src/scheduler.c \
+ *       src/task_manager.c src/memory_manager.c src/timer_manager.c \
+ *       src/arm_cortex_m.c
+ *   ./prof_host 2 > samples.txt
+ *   python3 tools/profiler/prof_fold.py --elf prof_host samples.txt > prof.folded
+ *   flamegraph.pl prof.folded > prof.svg
+ *
+ * Usage:
+ *   prof_host [seconds]     (default 1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rtos_config.h"
+#include "task_manager.h"
+#include "scheduler.h"
+#include "timer_manager.h"
+#include "memory_manager.h"
+#include "profiler.h"
+
+/* Demo counters the scheduler updates (defined by main.c on the target) */
+volatile int scheduler_iterations = 0;
+volatile int current_task_id = 0;
+
+static volatile uint32_t sink = 0;
+
+/* Work of different weight, kept out of line so each shows up by name */
+__attribute__((noinline)) static void checksum_block(void)
+{
+    for (uint32_t i = 0; i < 20000; i++) {
+        sink = sink * 31U + i;
+    }
+}
+
+__attribute__((noinline)) static void filter_sample(void)
+{
+    for (uint32_t i = 0; i < 5000; i++) {
+        sink ^= i << 3;
+    }
+}
+
+__attribute__((noinline)) static void poll_status(void)
+{
+    for (uint32_t i = 0; i < 1000; i++) {
+        sink += i;
+    }
+}
+
+static void heavy_task(void)
+{
+    checksum_block();
+    filter_sample();
+}
+
+static void medium_task(void)
+{
+    filter_sample();
+    poll_status();
+}
+
+static void light_task(void)
+{
+    poll_status();
+    scheduler_yield();
+}
+
+static void write_line(const char* line)
+{
+    puts(line);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 1U;
+
+    memory_init();
+    task_manager_init();
+    scheduler_init();
+    task_create(heavy_task, "Heavy", DEFAULT_STACK_SIZE);
+    task_create(medium_task, "Medium", DEFAULT_STACK_SIZE);
+    task_create(light_task, "Light", DEFAULT_STACK_SIZE);
+
+    profiler_init();
+    scheduler_start();
+    profiler_start();
+
+    uint64_t end = time_now_cycles() + (uint64_t)seconds * SYSTEM_CLOCK_HZ;
+    while (time_now_cycles() < end) {
+        scheduler_step();
+        /* Drain between slices, like a low-priority output task would */
+        profiler_write(write_line);
+    }
+
+    profiler_stop();
+    profiler_write(write_line);
+    if (profiler_get_dropped() != 0) {
+        fprintf(stderr, "prof_host: %lu samples dropped\n",
+                (unsigned long)profiler_get_dropped());
+    }
+    return 0;
+}
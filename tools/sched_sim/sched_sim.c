@@ -0,0 +1,587 @@
+/*
+ * sched_sim - offline schedulability simulator for the RTOS scheduler
+ *
+ * Links the real scheduler.c and task_manager.c on the host and replaces
+ * timer_manager.c with a simulated clock, so a task set can be checked
+ * against scheduler_run()'s policy before it goes on the target.
+ *
+ * Build (from the repository root):
+ *   gcc -O2 -DRTOS_PORT_HOST=1 -Iinclude -o sched_sim tools/sched_sim/sched_sim.c \
+ *       src/scheduler.c src/task_manager.c src/memory_manager.c src/arm_cortex_m.c \
+ *       src/work_queue.c src/job_system.c
+ *
+ * Usage:
+ *   sched_sim [-q slice_us] [-g call_us] [-n hyperperiods] [-s seed] [-H] [-w] [-j]
+ *             taskset.txt
+ *
+ *   -q  time slice (default TIME_SLICE_MS)
+ *   -g  work done per call of a task function (default 100 us). The
+ *       scheduler only checks the slice timer between calls, so this is
+ *       also the worst-case slice overrun
+ *   -n  number of hyperperiods to simulate (default 1000)
+ *   -s  random seed
+ *   -H  print response-time histograms
+ *   -w  also start the work queue task (top priority) and post a work item
+ *       each time a job finishes, to check the kernel's own tasks leave
+ *       the task set its CPU time
+ *   -j  likewise start the job system's worker tasks and submit a job each
+ *       time a job finishes
+ *
+ * Task set file, one task per line, times in microseconds:
+ *   # name  period  deadline  wcet_min  wcet_max  jitter  priority
+ *   ctrl    10000   10000     800       1500      200     3
+ * Each job's execution time is drawn uniformly from [wcet_min, wcet_max],
+ * and its release is delayed by a uniform [0, jitter] after the period
+ * start. Response times are measured from the period start. Priorities
+ * are passed to task_set_priority(); only the priority policies use them
+ * (build with -DRTOS_SCHED_POLICY=SCHED_POLICY_FIXED_PRIORITY or _PRIORITY_RR).
+ * The analytical bound in the report is the one for the policy built in.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rtos_config.h"
+#include "task_manager.h"
+#include "scheduler.h"
+#include "timer_manager.h"
+#include "memory_manager.h"
+#include "work_queue.h"
+#include "job_system.h"
+
+#define SIM_MAX_TASKS       (MAX_TASKS - 1)     /* IDLE takes one slot */
+#define SIM_HIST_BINS       20                  /* bins of deadline/10, up to 2x deadline */
+#define CYCLES_PER_US       (SYSTEM_CLOCK_HZ / 1000000U)
+#define CYCLES_PER_TICK     (SYSTEM_CLOCK_HZ / RTOS_TICK_RATE_HZ)
+#define SIM_STALL_STEPS     1000000U            /* steps without simulated time passing */
+
+/* ============================================================================
+ * SIMULATION STATE
+ * ============================================================================ */
+typedef struct {
+    char name[MAX_TASK_NAME_LENGTH];
+    uint64_t period;            /* all times in cycles */
+    uint64_t deadline;
+    uint64_t wcet_min;
+    uint64_t wcet_max;
+    uint64_t jitter;
+    uint8_t priority;
+
+    task_id_t task_id;
+    task_wait_list_t wait;
+    uint64_t arrival;           /* period start of the current/next job */
+    uint64_t release;           /* arrival + jitter */
+    uint64_t remaining;         /* work left in the current job, 0 = none */
+
+    uint64_t jobs;
+    uint64_t misses;
+    uint64_t response_max;
+    uint64_t response_sum;
+    uint64_t hist[SIM_HIST_BINS + 1];
+    uint64_t bound;
+} sim_task_t;
+
+static sim_task_t sim_tasks[SIM_MAX_TASKS];
+static int sim_task_count = 0;
+
+static uint64_t sim_now = 0;            /* simulated clock, cycles */
+static uint64_t sim_slice_end = 0;
+static uint64_t sim_slice_cycles = (uint64_t)TIME_SLICE_MS * 1000U * CYCLES_PER_US;
+static uint64_t sim_call_cycles = 100U * CYCLES_PER_US;
+static uint64_t sim_busy = 0;
+static uint64_t sim_rng = 0x9E3779B97F4A7C15ULL;
+
+static bool sim_work_queue = false;     /* -w */
+static work_item_t sim_work;
+static uint64_t sim_work_posted = 0;
+static uint64_t sim_work_done = 0;
+
+static bool sim_job_system = false;     /* -j */
+static job_t sim_job;
+static job_wait_group_t sim_job_group;
+static uint64_t sim_jobs_submitted = 0;
+static uint64_t sim_jobs_done = 0;
+
+/* Referenced by scheduler.c (normally defined by main.c) */
+volatile int scheduler_iterations = 0;
+volatile int current_task_id = 0;
+
+/* ============================================================================
+ * SIMULATED TIMER MANAGER
+ * ============================================================================ */
+uint32_t timer_calculate_slice_ticks(uint32_t time_slice_ms)
+{
+    (void)time_slice_ms;                /* -q overrides TIME_SLICE_MS */
+    return (uint32_t)sim_slice_cycles;
+}
+
+void timer_start_slice(uint32_t reload_ticks)
+{
+    sim_slice_end = sim_now + reload_ticks;
+}
+
+void timer_stop_slice(void)
+{
+}
+
+bool timer_slice_expired(void)
+{
+    /* The idle task only spins until the slice ends - skip ahead */
+    tcb_t* current = task_get_current();
+    if (current != NULL && current->task_function == scheduler_idle_task &&
+        sim_now < sim_slice_end) {
+        sim_now = sim_slice_end;
+    }
+    return sim_now >= sim_slice_end;
+}
+
+uint32_t timer_get_tick_count(void)
+{
+    return (uint32_t)(sim_now / CYCLES_PER_TICK);
+}
+
+void timer_timebase_init(void)
+{
+}
+
+uint64_t time_now_cycles(void)
+{
+    return sim_now;
+}
+
+uint32_t time_us_to_cycles(uint32_t us)
+{
+    return us * CYCLES_PER_US;
+}
+
+/* ============================================================================
+ * SIMULATED TASKS
+ * ============================================================================ */
+static uint64_t sim_random(void)
+{
+    /* xorshift64* */
+    sim_rng ^= sim_rng >> 12;
+    sim_rng ^= sim_rng << 25;
+    sim_rng ^= sim_rng >> 27;
+    return sim_rng * 0x2545F4914F6CDD1DULL;
+}
+
+static uint64_t sim_uniform(uint64_t lo, uint64_t hi)
+{
+    return (hi > lo) ? lo + sim_random() % (hi - lo + 1) : lo;
+}
+
+static void sim_work_fn(void* arg)
+{
+    (void)arg;
+    sim_work_done++;
+}
+
+static void sim_job_fn(void* arg)
+{
+    (void)arg;
+    sim_jobs_done++;
+}
+
+static void sim_next_job(sim_task_t* t)
+{
+    t->release = t->arrival + sim_uniform(0, t->jitter);
+}
+
+static void sim_job_done(sim_task_t* t)
+{
+    uint64_t response = sim_now - t->arrival;
+    uint64_t bin = response * 10U / t->deadline;
+
+    t->jobs++;
+    t->response_sum += response;
+    if (response > t->response_max) {
+        t->response_max = response;
+    }
+    if (response > t->deadline) {
+        t->misses++;
+    }
+    t->hist[bin < SIM_HIST_BINS ? bin : SIM_HIST_BINS]++;
+
+    t->arrival += t->period;
+    sim_next_job(t);
+
+    if (sim_work_queue && work_post(&sim_work)) {
+        sim_work_posted++;
+    }
+    /* One job in flight at a time - sim_job is reused */
+    if (sim_job_system && job_wait_group_done(&sim_job_group)) {
+        job_submit(&sim_job, sim_job_fn, NULL, &sim_job_group);
+        sim_jobs_submitted++;
+    }
+}
+
+/* One call of a task function: start the released job if needed, do one
+ * call's worth of work, or block until the next release */
+static void sim_task_body(int index)
+{
+    sim_task_t* t = &sim_tasks[index];
+
+    task_wait_complete(t, NULL);
+
+    if (t->remaining == 0) {
+        if (sim_now < t->release) {
+            uint64_t ticks = (t->release - sim_now + CYCLES_PER_TICK - 1U) / CYCLES_PER_TICK;
+            task_block_current(&t->wait, t, (uint32_t)ticks);
+            return;
+        }
+        t->remaining = sim_uniform(t->wcet_min, t->wcet_max);
+    }
+
+    uint64_t work = (t->remaining < sim_call_cycles) ? t->remaining : sim_call_cycles;
+    sim_now += work;
+    sim_busy += work;
+    t->remaining -= work;
+
+    if (t->remaining == 0) {
+        sim_job_done(t);
+    }
+}
+
+/* Task functions take no argument - one trampoline per slot */
+#define SIM_TRAMPOLINE(n)   static void sim_task_##n(void) { sim_task_body(n); }
+SIM_TRAMPOLINE(0)  SIM_TRAMPOLINE(1)  SIM_TRAMPOLINE(2)  SIM_TRAMPOLINE(3)
+SIM_TRAMPOLINE(4)  SIM_TRAMPOLINE(5)  SIM_TRAMPOLINE(6)  SIM_TRAMPOLINE(7)
+SIM_TRAMPOLINE(8)  SIM_TRAMPOLINE(9)  SIM_TRAMPOLINE(10) SIM_TRAMPOLINE(11)
+SIM_TRAMPOLINE(12) SIM_TRAMPOLINE(13) SIM_TRAMPOLINE(14) SIM_TRAMPOLINE(15)
+
+static void (*const sim_trampolines[])(void) = {
+    sim_task_0,  sim_task_1,  sim_task_2,  sim_task_3,
+    sim_task_4,  sim_task_5,  sim_task_6,  sim_task_7,
+    sim_task_8,  sim_task_9,  sim_task_10, sim_task_11,
+    sim_task_12, sim_task_13, sim_task_14, sim_task_15,
+};
+
+/* ============================================================================
+ * ANALYTICAL BOUND
+ * ============================================================================ */
+
+#if RTOS_SCHED_POLICY == SCHED_POLICY_RR
+/*
+ * Response-time bound for the round-robin ring, from the period start:
+ *
+ *   R = J + tick + (Q + g) + C + k*Q + sum_j min(k*(Q + g), ceil((R + J_j)/T_j) * C_j)
+ *
+ * J: release jitter. tick + (Q + g): a wake-up is only seen when the
+ * running slice ends (it can overrun by one call, g), and timeouts are
+ * rounded up to a tick. C: own worst-case execution. The task needs
+ * k = ceil(C/Q) slices, and before each of them every other ready task
+ * can take a slice of up to Q + g. The always-ready idle task takes Q.
+ * Iterated to a fixed point. 0 means no fixed point below 1000 periods.
+ */
+static uint64_t sim_response_bound(int index)
+{
+    const sim_task_t* t = &sim_tasks[index];
+    uint64_t q = sim_slice_cycles;
+    uint64_t g = sim_call_cycles;
+    uint64_t k = (t->wcet_max + q - 1U) / q;
+    uint64_t base = t->jitter + CYCLES_PER_TICK + (q + g) + t->wcet_max + k * q;
+    uint64_t r = base;
+
+    for (;;) {
+        uint64_t next = base;
+        for (int j = 0; j < sim_task_count; j++) {
+            const sim_task_t* o = &sim_tasks[j];
+            if (j == index) {
+                continue;
+            }
+            uint64_t demand = ((r + o->jitter + o->period - 1U) / o->period) * o->wcet_max;
+            uint64_t share = k * (q + g);
+            next += (demand < share) ? demand : share;
+        }
+        if (next == r) {
+            return r;
+        }
+        if (next > 1000U * t->period) {
+            return 0;
+        }
+        r = next;
+    }
+}
+#else
+/*
+ * Response-time bound for the priority policies, from the period start:
+ *
+ *   R = J + tick + (Q + g) + C + sum_{j in hep} ceil((R + J_j)/T_j) * C_j
+ *
+ * J, tick and (Q + g) as for round-robin: the wake-up is seen when the
+ * slice running at the release ends, whoever runs it - a lower-priority
+ * task keeps the CPU until then, but not beyond. C: own worst-case
+ * execution. hep: every other task of higher or equal priority; each job
+ * of them released in the window runs before this one completes (the
+ * equal ones at worst, in either policy). Iterated to a fixed point. 0
+ * means no fixed point below 1000 periods. Like the round-robin bound it
+ * assumes a job finishes within its period; beyond that the task's own
+ * late jobs delay it too, and the bound is only a rough figure.
+ */
+static uint64_t sim_response_bound(int index)
+{
+    const sim_task_t* t = &sim_tasks[index];
+    uint64_t base = t->jitter + CYCLES_PER_TICK + (sim_slice_cycles + sim_call_cycles) +
+                    t->wcet_max;
+    uint64_t r = base;
+
+    for (;;) {
+        uint64_t next = base;
+        for (int j = 0; j < sim_task_count; j++) {
+            const sim_task_t* o = &sim_tasks[j];
+            if (j == index || o->priority < t->priority) {
+                continue;
+            }
+            next += ((r + o->jitter + o->period - 1U) / o->period) * o->wcet_max;
+        }
+        if (next == r) {
+            return r;
+        }
+        if (next > 1000U * t->period) {
+            return 0;
+        }
+        r = next;
+    }
+}
+#endif
+
+/* ============================================================================
+ * TASK SET INPUT AND REPORT
+ * ============================================================================ */
+static int sim_load(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    char line[256];
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[64];
+        unsigned long long period, deadline, wmin, wmax, jitter;
+        unsigned prio;
+
+        if (line[0] == '#' || strspn(line, " \t\r\n") == strlen(line)) {
+            continue;
+        }
+        if (sscanf(line, "%63s %llu %llu %llu %llu %llu %u", name, &period, &deadline,
+                   &wmin, &wmax, &jitter, &prio) != 7 ||
+            period == 0 || deadline == 0 || wmin > wmax || prio > MAX_TASK_PRIORITY) {
+            fprintf(stderr, "%s: bad line: %s", path, line);
+            fclose(f);
+            return -1;
+        }
+        if (sim_task_count >= SIM_MAX_TASKS ||
+            sim_task_count >= (int)(sizeof(sim_trampolines) / sizeof(sim_trampolines[0]))) {
+            fprintf(stderr, "%s: more than %d tasks (raise MAX_TASKS)\n", path, sim_task_count);
+            fclose(f);
+            return -1;
+        }
+
+        sim_task_t* t = &sim_tasks[sim_task_count++];
+        snprintf(t->name, sizeof(t->name), "%.*s", MAX_TASK_NAME_LENGTH - 1, name);
+        t->period = period * CYCLES_PER_US;
+        t->deadline = deadline * CYCLES_PER_US;
+        t->wcet_min = wmin * CYCLES_PER_US;
+        t->wcet_max = wmax * CYCLES_PER_US;
+        t->jitter = jitter * CYCLES_PER_US;
+        t->priority = (uint8_t)prio;
+    }
+
+    fclose(f);
+    return sim_task_count > 0 ? 0 : -1;
+}
+
+static uint64_t sim_gcd(uint64_t a, uint64_t b)
+{
+    while (b != 0) {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+static void sim_report(uint64_t hyperperiod, uint64_t count, double wall)
+{
+    double us = (double)CYCLES_PER_US;
+    double seconds = (double)sim_now / SYSTEM_CLOCK_HZ;
+
+    printf("slice %.0f us, call %.0f us, hyperperiod %.0f us x %llu = %.1f s simulated "
+           "in %.2f s (%.0fx real time)\n",
+           sim_slice_cycles / us, sim_call_cycles / us, hyperperiod / us,
+           (unsigned long long)count, seconds, wall, wall > 0 ? seconds / wall : 0.0);
+    printf("CPU utilization: %.2f%% tasks, %.2f%% idle\n",
+           100.0 * sim_busy / sim_now, 100.0 - 100.0 * sim_busy / sim_now);
+    if (sim_work_queue) {
+        printf("work queue: %llu items posted, %llu run\n",
+               (unsigned long long)sim_work_posted, (unsigned long long)sim_work_done);
+    }
+    if (sim_job_system) {
+        printf("job system: %llu jobs submitted, %llu run\n",
+               (unsigned long long)sim_jobs_submitted, (unsigned long long)sim_jobs_done);
+    }
+    printf("\n");
+
+    printf("%-15s %4s %10s %10s %10s %10s %10s %10s %s\n", "task", "prio", "jobs",
+           "misses", "deadline", "mean_rt", "max_rt", "bound", "");
+    for (int i = 0; i < sim_task_count; i++) {
+        sim_task_t* t = &sim_tasks[i];
+        char bound[32];
+
+        if (t->bound != 0) {
+            snprintf(bound, sizeof(bound), "%.0f", t->bound / us);
+        } else {
+            snprintf(bound, sizeof(bound), "none");
+        }
+        printf("%-15s %4u %10llu %10llu %10.0f %10.0f %10.0f %10s %s\n", t->name,
+               t->priority, (unsigned long long)t->jobs, (unsigned long long)t->misses,
+               t->deadline / us,
+               t->jobs ? (double)t->response_sum / (double)t->jobs / us : 0.0,
+               t->response_max / us, bound,
+               (t->bound != 0 && t->response_max > t->bound) ? "(max above bound!)" :
+               (t->bound != 0 && t->bound > t->deadline) ? "(bound misses deadline)" : "");
+    }
+    printf("(times in us)\n");
+}
+
+static void sim_histograms(void)
+{
+    for (int i = 0; i < sim_task_count; i++) {
+        sim_task_t* t = &sim_tasks[i];
+        uint64_t peak = 1;
+
+        for (int b = 0; b <= SIM_HIST_BINS; b++) {
+            if (t->hist[b] > peak) {
+                peak = t->hist[b];
+            }
+        }
+        printf("\n%s response time (bins of deadline/10)\n", t->name);
+        for (int b = 0; b <= SIM_HIST_BINS; b++) {
+            int bar = (int)(t->hist[b] * 50U / peak);
+            if (b < SIM_HIST_BINS) {
+                printf(" %3d-%3d%% %10llu |", b * 10, b * 10 + 10,
+                       (unsigned long long)t->hist[b]);
+            } else {
+                printf("   >%3d%% %10llu |", SIM_HIST_BINS * 10,
+                       (unsigned long long)t->hist[b]);
+            }
+            printf("%.*s\n", bar, "##################################################");
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t hyperperiods = 1000;
+    bool histograms = false;
+    const char* path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-H") == 0) {
+            histograms = true;
+        } else if (strcmp(argv[i], "-w") == 0) {
+            sim_work_queue = true;
+        } else if (strcmp(argv[i], "-j") == 0) {
+            sim_job_system = true;
+        } else if (i + 1 < argc && strcmp(argv[i], "-q") == 0) {
+            sim_slice_cycles = strtoull(argv[++i], NULL, 0) * CYCLES_PER_US;
+        } else if (i + 1 < argc && strcmp(argv[i], "-g") == 0) {
+            sim_call_cycles = strtoull(argv[++i], NULL, 0) * CYCLES_PER_US;
+        } else if (i + 1 < argc && strcmp(argv[i], "-n") == 0) {
+            hyperperiods = strtoull(argv[++i], NULL, 0);
+        } else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+            sim_rng = strtoull(argv[++i], NULL, 0) | 1U;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path == NULL || sim_slice_cycles == 0 || sim_call_cycles == 0 ||
+        sim_slice_cycles > 0x00FFFFFFU) {
+        fprintf(stderr, "usage: %s [-q slice_us] [-g call_us] [-n hyperperiods] "
+                        "[-s seed] [-H] [-w] [-j] taskset.txt\n", argv[0]);
+        return 2;
+    }
+    if (sim_load(path) != 0) {
+        return 2;
+    }
+
+    uint64_t hyperperiod = sim_tasks[0].period;
+    for (int i = 1; i < sim_task_count; i++) {
+        hyperperiod = hyperperiod / sim_gcd(hyperperiod, sim_tasks[i].period) * sim_tasks[i].period;
+    }
+
+    memory_init();
+    task_manager_init();
+    scheduler_init();
+    for (int i = 0; i < sim_task_count; i++) {
+        sim_task_t* t = &sim_tasks[i];
+        task_wait_list_init(&t->wait);
+        sim_next_job(t);
+        t->task_id = task_create_stackless(sim_trampolines[i], t->name);
+        task_set_priority(t->task_id, t->priority);
+        t->bound = sim_response_bound(i);
+    }
+    if (sim_work_queue) {
+        work_init(&sim_work, sim_work_fn, NULL);
+        if (work_queue_init() != RTOS_SUCCESS) {
+            fprintf(stderr, "no task slot left for the work queue (raise MAX_TASKS)\n");
+            return 2;
+        }
+    }
+    if (sim_job_system) {
+        job_wait_group_init(&sim_job_group);
+        if (job_system_init() != RTOS_SUCCESS) {
+            fprintf(stderr, "no task slot left for the job workers (raise MAX_TASKS)\n");
+            return 2;
+        }
+    }
+
+    clock_t start = clock();
+    uint64_t end = hyperperiod * hyperperiods;
+    uint64_t last_now = 0;
+    uint32_t stalled = 0;
+    scheduler_start();
+    while (sim_now < end) {
+        scheduler_step();
+        /* Only the task set and the idle task advance the clock; a task that
+         * never blocks and outranks them all stops it */
+        stalled = (sim_now == last_now) ? stalled + 1U : 0U;
+        last_now = sim_now;
+        if (stalled >= SIM_STALL_STEPS) {
+            tcb_t* last = task_get_current();
+            task_info_t* info = (last != NULL) ? task_get_info(last->task_id) : NULL;
+            fprintf(stderr, "simulated time stopped at %.0f us: task '%s' never blocks "
+                            "and starves everything below it\n",
+                    (double)sim_now / CYCLES_PER_US, info != NULL ? info->task_name : "?");
+            return 1;
+        }
+    }
+    double wall = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* A job still unfinished past its deadline is a miss too - a task that
+     * never got the CPU would otherwise show none */
+    for (int i = 0; i < sim_task_count; i++) {
+        sim_task_t* t = &sim_tasks[i];
+        if (sim_now > t->arrival + t->deadline) {
+            t->misses++;
+        }
+    }
+
+    sim_report(hyperperiod, hyperperiods, wall);
+    if (histograms) {
+        sim_histograms();
+    }
+
+    for (int i = 0; i < sim_task_count; i++) {
+        if (sim_tasks[i].misses != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}